@@ -6,6 +6,37 @@
 #include <chrono>
 #include <map>
 #include <algorithm> // Necessário para std::max/std::min
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <new>
+#include <cstdint>
+#include <cstdarg>
+#include <cstring>
+#include <cstddef>
+#include <iterator>
+#include <initializer_list>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AFFINE_SSE 1 // Composição das transformações afins com SSE
+#define MIXER_SSE 1  // Mixagem das vozes de áudio com SSE
+#define PARTICLE_SSE 1 // Integração das partículas no CPU com SSE
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>    // Pico de memória no benchmark
+#else
+#include <sys/resource.h>
+#endif
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -13,6 +44,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp> // Para debug
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>  // Atlas de fonte do HUD
+#include <stb_easy_font.h> // Fonte de reserva quando não há TTF
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>     // Texturas do campo, arquibancadas e uniformes
 
 // --- CONFIGURAÇÕES GLOBAIS ---
 const int WIDTH = 800;
@@ -21,11 +57,11 @@ const float PI = 3.14159265359f;
 
 // --- Estados do Jogo ---
 enum GameState { STATE_READY, STATE_RUNNING_UP, STATE_KICKING, STATE_BALL_IN_FLIGHT, STATE_SAVED, STATE_GOAL, STATE_RESETTING, STATE_GAMEOVER, STATE_CELEBRATING};
-GameState g_gameState = STATE_READY;
+thread_local GameState g_gameState = STATE_READY;
 enum KeeperState { KEEPER_IDLE, KEEPER_DIVING };
-KeeperState g_keeperState = KEEPER_IDLE;
+thread_local KeeperState g_keeperState = KEEPER_IDLE;
 enum Team { TEAM_1, TEAM_2 };
-Team g_currentKicker = TEAM_1;
+thread_local Team g_currentKicker = TEAM_1;
 const glm::vec4 g_team1Color1(0.1f, 0.1f, 0.1f, 1.0f); const glm::vec4 g_team1Color2(0.9f, 0.9f, 0.9f, 1.0f);
 const glm::vec4 g_team2Color1(0.0f, 0.2f, 0.8f, 1.0f); const glm::vec4 g_team2Color2(0.0f, 0.2f, 0.8f, 1.0f);
 const glm::vec4 g_keeperColor(1.0f, 1.0f, 0.2f, 1.0f);
@@ -34,15 +70,17 @@ const glm::vec4 g_skinColor(1.0f, 0.8f, 0.6f, 1.0f);
 const glm::vec4 g_gloveColor(0.1f, 0.1f, 0.1f, 1.0f); // NOVO: Cor Preta para Luvas
 
 // --- Lógica do Placar ---
-int g_currentKick = 0;
-std::vector<int> g_team1Results = {0, 0, 0};
-std::vector<int> g_team2Results = {0, 0, 0};
+// thread_local: com o pipeline (ver PIPELINE SIMULAÇÃO / RENDER) a thread da simulação tem o estado vivo
+// e a de render uma cópia aplicada do último snapshot publicado
+thread_local int g_currentKick = 0;
+thread_local std::vector<int> g_team1Results = {0, 0, 0};
+thread_local std::vector<int> g_team2Results = {0, 0, 0};
 
 // --- Posições e Dimensões ---
 glm::vec3 g_playerStartPos(2.0f, 1.1f, 8.0f);
-glm::vec3 g_playerPosition(g_playerStartPos);
-glm::vec3 g_ballPosition(0.0f, 0.1f, 6.0f);
-glm::vec3 g_keeperPosition(0.0f, 0.8f, -10.0f);
+thread_local glm::vec3 g_playerPosition(g_playerStartPos);
+thread_local glm::vec3 g_ballPosition(0.0f, 0.1f, 6.0f);
+thread_local glm::vec3 g_keeperPosition(0.0f, 0.8f, -10.0f);
 
 const glm::vec3 g_playerTorsoSize(0.5f, 0.7f, 0.3f);
 const glm::vec3 g_playerLimbSize(0.15f, 0.35f, 0.15f);
@@ -59,19 +97,28 @@ const glm::vec3 g_goalPostSize(0.2f, 2.0f, 0.2f); // Ainda usado para colisões,
 const float g_goalLineZ = -10.0f;
 const float g_netDepth = 1.5f;
 const float g_backNetZ = g_goalLineZ - g_netDepth;
-bool g_goalRecorded = false;
+
+// --- Estado interno da simulação ---
+// Só updateGame lê e escreve (a thread da simulação com o pipeline, a principal sem ele). Fica fora do
+// GameSnapshot porque o desenho não depende dele; a entrada chega pela fila g_inputQueue.
+struct SimulationState {
+    bool goalRecorded = false;
+    glm::vec3 ballVelocity = glm::vec3(0.0f);
+    int kickRequest = 0;       // Canto escolhido e ainda não batido (0 = nenhum)
+    float resetTimer = 0.0f;   // Espera até a próxima cobrança
+    float reboundTimer = 0.0f; // Rebote depois da defesa
+};
+thread_local SimulationState g_sim;
 
 // --- Física, IA e Animação ---
-glm::vec3 g_ballVelocity(0.0f);
-glm::vec3 g_keeperTargetPos(g_keeperPosition);
+thread_local glm::vec3 g_keeperTargetPos(0.0f, 0.8f, -10.0f);
 float g_ballSpeed = 15.0f;
 float g_keeperDiveSpeed = 3.0f;
 float g_playerRunSpeed = 3.0f;
-int   g_kickRequest = 0;
-float g_resetTimer = 0.0f;
-float g_netAnimationTimer = 0.0f;
-float g_reboundTimer = 0.0f;
-float g_animationTimer = 0.0f;
+thread_local double g_kickInputTime = 0.0; // Entrada de chute consumida no último updateGame (0 = nenhuma)
+thread_local float g_netAnimationTimer = 0.0f;
+thread_local float g_animationTimer = 0.0f;
+thread_local float g_matchTime = 0.0f; // Tempo de simulação acumulado desde o início da disputa
 
 std::default_random_engine g_randomEngine(std::chrono::system_clock::now().time_since_epoch().count());
 std::uniform_int_distribution<int> g_keeperChoice(1, 3);
@@ -94,23 +141,922 @@ glm::mat4 g_viewMatrix; // Matriz view (calculada)
 bool g_isMouseDragging = false;
 double g_lastMouseX, g_lastMouseY;
 
+// --- Estatísticas do frame (zeradas a cada frame, lidas pelo benchmark) ---
+struct FrameStats {
+    int drawCalls = 0;
+    int culledItems = 0; // Itens descartados pelo frustum culling (somando todas as câmeras)
+    int views = 0;
+    int translucentItems = 0; // Translúcidos visíveis submetidos (somando todas as câmeras)
+    int lights = 0;
+    int lightRefs = 0;        // Entradas nas listas de luzes dos clusters (somando todas as câmeras)
+    int lightsDropped = 0, truncatedClusters = 0; // Pares luz/cluster cortados pelo limite por cluster / clusters afetados
+    int textureUploadBytes = 0;
+    int occlusionTested = 0, occlusionRejected = 0; // Itens testados contra o Z hierárquico / descartados
+    float renderScale = 1.0f; // Escala da resolução dinâmica usada no frame
+    int gpuObjects = 0; // Objetos opacos culled/desenhados na GPU (somando todas as câmeras)
+    int stateIssued = 0, stateSkipped = 0; // Chamadas de estado/uniform enviadas ao driver / evitadas pelo cache GL
+    float simMs = 0.0f; // Último passo da thread de simulação (0 sem o pipeline)
+    int particles = 0;  // Partículas vivas (estimativa no caminho da GPU)
+    int grassBlades = 0; // Tufos de grama desenhados (somando todas as câmeras)
+};
+FrameStats g_frameStats;
+
+// Multiplicador da torcida sobre o layout de drawCrowd (1 = layout original; usado pelo benchmark)
+int g_crowdScale = 1;
+bool g_multiView = false; // Tecla V / --multiview: câmeras extras de transmissão
+bool g_showHud = true;    // Tecla H / --no-hud
+bool g_occlusionCulling = true; // Tecla O / --no-occlusion
+bool g_dynamicResolution = true; // --no-dynres (ver RESOLUÇÃO DINÂMICA)
+bool g_gpuDriven = true;         // Tecla G / --no-gpu-driven: opacos por multi-draw indireto quando há GL 4.3
+bool g_lowLatency = false;       // Tecla L / --low-latency (ver LATÊNCIA DE ENTRADA)
+bool g_grass = true;             // Tecla F / --no-grass (ver GRAMA)
+float g_grassDensity = 0.35f;    // --grass-density: fração do tile de grama usada em densidade cheia
+bool g_textureReportRequest = false; // Tecla R: imprime a residência das texturas no próximo frame
+enum TransparencyMode { TRANSPARENCY_OIT, TRANSPARENCY_SORTED };
+TransparencyMode g_transparencyMode = TRANSPARENCY_OIT; // Tecla T / --sorted-blend
+int g_translucentStress = 0; // Painéis translúcidos extras (só para benchmark)
+int g_extraLights = 0;       // Sinalizadores além dos refletores e do placar (--lights N / benchmark)
+int g_workerThreads = -1;    // --threads N; -1 = núcleos - 1
+enum PipelineMode {
+    PIPELINE_OFF,     // --no-pipeline: simula e desenha em sequência na thread principal
+    PIPELINE_LATEST,  // Desenha o pacote mais novo da simulação, sem nunca esperar por ela
+    PIPELINE_BOUNDED  // --pipeline-bounded: espera o passo do frame anterior (entrada com no máximo 1 frame de atraso)
+};
+PipelineMode g_pipelineMode = PIPELINE_LATEST; // Ver PIPELINE SIMULAÇÃO / RENDER
+
+// --- ALOCADOR DE FRAME ---
+// Dados temporários do frame (listas, matrizes, cores) saem de uma arena linear por thread,
+// zerada no fim de cada frame. Assim o loop em regime não faz nenhuma alocação no heap.
+
+// Contador de alocações no heap desta thread: operator new e os blocos que as arenas pedem ao malloc
+// (o --bench confere que fica parado no regime; a thread da simulação publica o seu no pipeline)
+thread_local unsigned long long t_heapAllocCount = 0;
+
+// Todas as formas substituíveis passam por aqui (new[] e nothrow chamam estas; as alinhadas têm as suas)
+void* operator new(size_t size) {
+    t_heapAllocCount++;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    t_heapAllocCount++;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+// Tipos com alignas acima do padrão (ex.: alvos de SSE); o MSVC não tem aligned_alloc
+void* alignedHeapAlloc(size_t size, size_t alignment) {
+    t_heapAllocCount++;
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, alignment);
+#else
+    return std::aligned_alloc(alignment, ((size ? size : 1) + alignment - 1) & ~(alignment - 1));
+#endif
+}
+void alignedHeapFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+void* operator new(size_t size, std::align_val_t align) {
+    void* p = alignedHeapAlloc(size, (size_t)align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return alignedHeapAlloc(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return alignedHeapAlloc(size, (size_t)align); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedHeapFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedHeapFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { alignedHeapFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { alignedHeapFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedHeapFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedHeapFree(p); }
+
+struct FrameArena {
+    static const size_t INITIAL_CAPACITY = 1 << 20; // 1 MiB; cresce sozinha se um frame precisar de mais
+    static const int MAX_OVERFLOW_BLOCKS = 32;
+
+    char* memory = nullptr;
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t highWater = 0;      // Maior uso da arena em um único frame
+    size_t frameOverflow = 0;  // Bytes que não couberam neste frame (foram para o heap)
+    void* overflowBlocks[MAX_OVERFLOW_BLOCKS];
+    int overflowCount = 0;
+    const char* name = "?";
+
+    void* allocate(size_t size, size_t align) {
+        size_t start = (offset + align - 1) & ~(align - 1);
+        if (memory && start + size <= capacity) {
+            offset = start + size;
+            return memory + start;
+        }
+        // Estourou: atende pelo heap neste frame e aumenta a arena no próximo reset
+        if (overflowCount == MAX_OVERFLOW_BLOCKS) throw std::bad_alloc();
+        void* block = std::malloc(size + align);
+        if (!block) throw std::bad_alloc();
+        t_heapAllocCount++;
+        frameOverflow += size + align;
+        overflowBlocks[overflowCount++] = block;
+        return (void*)(((uintptr_t)block + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    void reset() {
+        size_t used = offset + frameOverflow;
+        highWater = std::max(highWater, used);
+        for (int i = 0; i < overflowCount; ++i) std::free(overflowBlocks[i]);
+        overflowCount = 0;
+        if (!memory || frameOverflow > 0) {
+            std::free(memory);
+            capacity = std::max(INITIAL_CAPACITY, used + used / 2);
+            memory = (char*)std::malloc(capacity);
+            t_heapAllocCount++;
+        }
+        offset = 0; frameOverflow = 0;
+    }
+
+    ~FrameArena() {
+        for (int i = 0; i < overflowCount; ++i) std::free(overflowBlocks[i]);
+        std::free(memory);
+    }
+};
+
+// Registro das arenas de todas as threads para as estatísticas de debug
+const int MAX_ARENAS = 16;
+FrameArena* g_arenas[MAX_ARENAS];
+std::atomic<int> g_arenaCount{0};
+
+FrameArena& frameArena() {
+    thread_local FrameArena* arena = nullptr;
+    if (!arena) {
+        thread_local FrameArena storage;
+        arena = &storage;
+        arena->reset();
+        int slot = g_arenaCount.fetch_add(1);
+        if (slot < MAX_ARENAS) g_arenas[slot] = arena;
+    }
+    return *arena;
+}
+
+// Adaptador para containers STL transitórios (válidos só até o fim do frame)
+template <typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+    FrameArena* arena;
+
+    ArenaAllocator() : arena(&frameArena()) {}
+    explicit ArenaAllocator(FrameArena& target) : arena(&target) {} // Arena de outro dono (ex.: pacotes do pipeline)
+    template <typename U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return (T*)arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {} // Liberado em bloco no reset da arena
+};
+template <typename T, typename U> bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+template <typename T, typename U> bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+template <typename T> using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+void printArenaStats() {
+    int count = std::min(g_arenaCount.load(), MAX_ARENAS);
+    for (int i = 0; i < count; ++i) {
+        std::cout << "Arena de frame [" << g_arenas[i]->name << "]: pico " << g_arenas[i]->highWater / 1024.0
+                  << " KiB, capacidade " << g_arenas[i]->capacity / 1024.0 << " KiB" << std::endl;
+    }
+}
+
+// --- POOL DE THREADS ---
+// Workers fixos para trabalho paralelo dentro do frame. parallelFor divide [0, count) em blocos
+// que a thread chamadora também executa; nenhuma alocação depois de start().
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    void (*job)(void* context, int begin, int end) = nullptr;
+    void* context = nullptr;
+    int count = 0, chunkSize = 1;
+    std::atomic<int> nextChunk{0};
+    int busyWorkers = 0;
+    unsigned generation = 0;
+    bool quit = false;
+
+    // Pega blocos até acabar; usado pelos workers e pela thread que chamou parallelFor
+    void runChunks() {
+        for (;;) {
+            int begin = nextChunk.fetch_add(1, std::memory_order_relaxed) * chunkSize;
+            if (begin >= count) return;
+            job(context, begin, std::min(begin + chunkSize, count));
+        }
+    }
+
+    void workerLoop() {
+        unsigned seenGeneration = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || generation != seenGeneration; });
+                if (quit) return;
+                seenGeneration = generation;
+            }
+            runChunks();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0) finished.notify_one();
+        }
+    }
+
+    void start(int threadCount) {
+        workers.reserve(threadCount);
+        for (int i = 0; i < threadCount; ++i) workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    void stop() {
+        { std::lock_guard<std::mutex> lock(mutex); quit = true; }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        workers.clear();
+    }
+
+    template <typename F>
+    void parallelFor(int itemCount, int itemsPerChunk, F& fn) {
+        if (workers.empty() || itemCount <= itemsPerChunk) { if (itemCount > 0) fn(0, itemCount); return; }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = [](void* ctx, int begin, int end) { (*static_cast<F*>(ctx))(begin, end); };
+            context = &fn;
+            count = itemCount; chunkSize = itemsPerChunk;
+            nextChunk.store(0, std::memory_order_relaxed);
+            busyWorkers = (int)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        runChunks();
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return busyWorkers == 0; });
+    }
+};
+ThreadPool g_threadPool;
+
+// --- CACHE DE ESTADO GL ---
+// Camada fina sobre o estado que o frame mexe: programa, VAO, framebuffer, buffers, texturas por unidade,
+// teste de profundidade/blend/scissor, função de blend, máscara de profundidade e valores de uniforms
+// (por programa, como no GL). Chamadas que não mudariam nada não chegam ao driver.
+// Tudo que roda por frame passa por aqui; a inicialização chama o GL direto e termina com resetGLStateCache().
+// Com --gl-validate cada chamada pulada confere o valor guardado com o do driver.
+const unsigned int GL_STATE_UNKNOWN = ~0u;
+const int GL_CACHE_TEXTURE_UNITS = 8;
+const int GL_CACHE_PROGRAMS = 16;
+const int GL_CACHE_UNIFORMS = 32;
+const int GL_CACHE_UNIFORM_BYTES = 64; // Cabe um mat4
+
+// Como o driver devolve o valor na validação (ROWS_4x3: 3 linhas de 4 enviadas com transpose = GL_TRUE)
+enum UniformKind { UNIFORM_FLOAT, UNIFORM_INT, UNIFORM_ROWS_4x3 };
+
+struct CachedUniform {
+    const char* name; // Literais: a busca compara o ponteiro antes do texto
+    int location;
+    int bytes;        // 0 = valor desconhecido (nunca enviado ou cache zerado)
+    UniformKind kind;
+    unsigned char value[GL_CACHE_UNIFORM_BYTES];
+};
+
+struct CachedProgram {
+    unsigned int program;
+    int count;
+    CachedUniform uniforms[GL_CACHE_UNIFORMS];
+};
+
+struct GLStateCache {
+    unsigned int program, vao, framebuffer;
+    unsigned int arrayBuffer, textureBuffer, pixelUnpackBuffer;
+    unsigned int activeUnit; // GL_TEXTUREi
+    unsigned int texture2D[GL_CACHE_TEXTURE_UNITS], bufferTexture[GL_CACHE_TEXTURE_UNITS];
+    int depthTest, blend, scissorTest, depthMask; // -1 = desconhecido
+    unsigned int blendFunc[4];                    // srcRGB, dstRGB, srcAlpha, dstAlpha
+    CachedProgram programs[GL_CACHE_PROGRAMS];
+    int programCount = 0;
+    bool validate = false; // --gl-validate
+    int mismatches = 0;
+};
+GLStateCache g_glState;
+
+void resetGLStateCache() {
+    GLStateCache& s = g_glState;
+    s.program = s.vao = s.framebuffer = GL_STATE_UNKNOWN;
+    s.arrayBuffer = s.textureBuffer = s.pixelUnpackBuffer = GL_STATE_UNKNOWN;
+    s.activeUnit = GL_STATE_UNKNOWN;
+    for (int i = 0; i < GL_CACHE_TEXTURE_UNITS; ++i) s.texture2D[i] = s.bufferTexture[i] = GL_STATE_UNKNOWN;
+    s.depthTest = s.blend = s.scissorTest = s.depthMask = -1;
+    for (unsigned int& f : s.blendFunc) f = GL_STATE_UNKNOWN;
+    // As posições dos uniforms continuam válidas; só os valores são esquecidos
+    for (int p = 0; p < s.programCount; ++p)
+        for (int u = 0; u < s.programs[p].count; ++u) s.programs[p].uniforms[u].bytes = 0;
+}
+
+void reportStateMismatch(const char* what, long long tracked, long long actual) {
+    if (g_glState.mismatches++ < 16)
+        std::cerr << "Cache GL divergente (" << what << "): guardado " << tracked << ", driver " << actual << std::endl;
+}
+
+// Validação de um valor inteiro guardado; devolve false (e reporta) se o driver discordar
+bool validateInteger(const char* what, GLenum query, long long tracked) {
+    GLint actual = 0;
+    glGetIntegerv(query, &actual);
+    if (actual == tracked) return true;
+    reportStateMismatch(what, tracked, actual);
+    return false;
+}
+
+// Núcleo do cache: true = pode pular. Na validação, uma divergência força a chamada.
+bool stateMatches(unsigned int tracked, unsigned int value, const char* what, GLenum query) {
+    if (tracked != value) { g_frameStats.stateIssued++; return false; }
+    if (g_glState.validate && !validateInteger(what, query, tracked)) { g_frameStats.stateIssued++; return false; }
+    g_frameStats.stateSkipped++;
+    return true;
+}
+
+void useProgram(unsigned int program) {
+    if (stateMatches(g_glState.program, program, "programa", GL_CURRENT_PROGRAM)) return;
+    glUseProgram(program);
+    g_glState.program = program;
+}
+
+void bindVertexArray(unsigned int vao) {
+    if (stateMatches(g_glState.vao, vao, "VAO", GL_VERTEX_ARRAY_BINDING)) return;
+    glBindVertexArray(vao);
+    g_glState.vao = vao;
+}
+
+void bindFramebuffer(unsigned int framebuffer) {
+    if (stateMatches(g_glState.framebuffer, framebuffer, "framebuffer", GL_DRAW_FRAMEBUFFER_BINDING)) return;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    g_glState.framebuffer = framebuffer;
+}
+
+// GL_ELEMENT_ARRAY_BUFFER faz parte do VAO: não passa por aqui
+void bindBuffer(GLenum target, unsigned int buffer) {
+    unsigned int* tracked = nullptr; GLenum query = 0;
+    switch (target) {
+        case GL_ARRAY_BUFFER:        tracked = &g_glState.arrayBuffer; query = GL_ARRAY_BUFFER_BINDING; break;
+        case GL_TEXTURE_BUFFER:      tracked = &g_glState.textureBuffer; query = GL_TEXTURE_BUFFER_BINDING; break;
+        case GL_PIXEL_UNPACK_BUFFER: tracked = &g_glState.pixelUnpackBuffer; query = GL_PIXEL_UNPACK_BUFFER_BINDING; break;
+        default: glBindBuffer(target, buffer); g_frameStats.stateIssued++; return;
+    }
+    if (stateMatches(*tracked, buffer, "buffer", query)) return;
+    glBindBuffer(target, buffer);
+    *tracked = buffer;
+}
+
+void activeTextureUnit(unsigned int unit) {
+    if (stateMatches(g_glState.activeUnit, GL_TEXTURE0 + unit, "unidade de textura", GL_ACTIVE_TEXTURE)) return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    g_glState.activeUnit = GL_TEXTURE0 + unit;
+}
+
+// Liga a textura na unidade (a unidade ativa só muda quando a ligação precisa acontecer)
+void bindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+    unsigned int& tracked = target == GL_TEXTURE_BUFFER ? g_glState.bufferTexture[unit] : g_glState.texture2D[unit];
+    bool same = tracked == texture;
+    if (same && g_glState.validate) {
+        GLint previous = 0, actual = 0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &previous);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glGetIntegerv(target == GL_TEXTURE_BUFFER ? GL_TEXTURE_BINDING_BUFFER : GL_TEXTURE_BINDING_2D, &actual);
+        glActiveTexture(previous);
+        if ((unsigned int)actual != tracked) { reportStateMismatch("textura", tracked, actual); same = false; }
+    }
+    if (same) { g_frameStats.stateSkipped++; return; }
+    activeTextureUnit(unit);
+    glBindTexture(target, texture);
+    g_frameStats.stateIssued++;
+    tracked = texture;
+}
+
+// Para glTexImage/glTexSubImage/glTexParameter: a textura precisa estar ligada na unidade ATIVA
+void bindTextureForUpdate(unsigned int texture) {
+    activeTextureUnit(0);
+    bindTexture(0, GL_TEXTURE_2D, texture);
+}
+
+// Uma textura apagada some das unidades em que estava ligada (e o nome pode ser reaproveitado)
+void forgetTexture(unsigned int texture) {
+    for (int i = 0; i < GL_CACHE_TEXTURE_UNITS; ++i) {
+        if (g_glState.texture2D[i] == texture) g_glState.texture2D[i] = 0;
+        if (g_glState.bufferTexture[i] == texture) g_glState.bufferTexture[i] = 0;
+    }
+}
+
+void setCapability(GLenum cap, bool enabled) {
+    int* tracked = cap == GL_DEPTH_TEST ? &g_glState.depthTest : cap == GL_BLEND ? &g_glState.blend : &g_glState.scissorTest;
+    if (*tracked == (int)enabled) {
+        bool valid = !g_glState.validate || glIsEnabled(cap) == (enabled ? GL_TRUE : GL_FALSE);
+        if (!valid) reportStateMismatch("glEnable", enabled, !enabled);
+        if (valid) { g_frameStats.stateSkipped++; return; }
+    }
+    if (enabled) glEnable(cap); else glDisable(cap);
+    g_frameStats.stateIssued++;
+    *tracked = enabled;
+}
+
+void setDepthMask(bool write) {
+    if (stateMatches((unsigned int)g_glState.depthMask, write ? 1 : 0, "glDepthMask", GL_DEPTH_WRITEMASK)) return;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+    g_glState.depthMask = write;
+}
+
+void setBlendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+    unsigned int* f = g_glState.blendFunc;
+    bool same = f[0] == srcRGB && f[1] == dstRGB && f[2] == srcAlpha && f[3] == dstAlpha;
+    if (same && g_glState.validate) {
+        same = validateInteger("blend src rgb", GL_BLEND_SRC_RGB, f[0]) & validateInteger("blend dst rgb", GL_BLEND_DST_RGB, f[1])
+             & validateInteger("blend src alpha", GL_BLEND_SRC_ALPHA, f[2]) & validateInteger("blend dst alpha", GL_BLEND_DST_ALPHA, f[3]);
+    }
+    if (same) { g_frameStats.stateSkipped++; return; }
+    glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    g_frameStats.stateIssued++;
+    f[0] = srcRGB; f[1] = dstRGB; f[2] = srcAlpha; f[3] = dstAlpha;
+}
+
+void setBlendFunc(GLenum src, GLenum dst) { setBlendFunc(src, dst, src, dst); }
+
+// Entrada do uniform 'name' no programa atual (posição consultada uma vez por programa)
+CachedUniform* cachedUniform(const char* name) {
+    GLStateCache& s = g_glState;
+    CachedProgram* program = nullptr;
+    for (int p = 0; p < s.programCount && !program; ++p)
+        if (s.programs[p].program == s.program) program = &s.programs[p];
+    for (int p = 0; p < s.programCount && !program; ++p)
+        if (s.programs[p].program == 0) program = &s.programs[p]; // Entrada de um programa já apagado
+    if (!program) {
+        if (s.programCount == GL_CACHE_PROGRAMS) return nullptr;
+        program = &s.programs[s.programCount++];
+    }
+    if (program->program != s.program) {
+        program->program = s.program; program->count = 0;
+    }
+    for (int u = 0; u < program->count; ++u)
+        if (program->uniforms[u].name == name) return &program->uniforms[u];
+    for (int u = 0; u < program->count; ++u)
+        if (std::strcmp(program->uniforms[u].name, name) == 0) return &program->uniforms[u];
+    if (program->count == GL_CACHE_UNIFORMS) return nullptr;
+    CachedUniform& uniform = program->uniforms[program->count++];
+    uniform.name = name;
+    uniform.location = glGetUniformLocation(s.program, name);
+    uniform.bytes = 0;
+    return &uniform;
+}
+
+// Confere o valor guardado com o do programa no driver
+bool validateUniform(const CachedUniform& uniform) {
+    float actual[GL_CACHE_UNIFORM_BYTES / 4], expected[GL_CACHE_UNIFORM_BYTES / 4];
+    int count = uniform.bytes / 4;
+    if (uniform.kind == UNIFORM_INT) {
+        GLint values[GL_CACHE_UNIFORM_BYTES / 4];
+        glGetUniformiv(g_glState.program, uniform.location, values);
+        for (int i = 0; i < count; ++i) actual[i] = (float)values[i];
+        const GLint* stored = (const GLint*)uniform.value;
+        for (int i = 0; i < count; ++i) expected[i] = (float)stored[i];
+    } else {
+        glGetUniformfv(g_glState.program, uniform.location, actual);
+        std::memcpy(expected, uniform.value, uniform.bytes);
+        if (uniform.kind == UNIFORM_ROWS_4x3) // O driver devolve por coluna (4 colunas de 3)
+            for (int r = 0; r < 3; ++r) for (int c = 0; c < 4; ++c) expected[c * 3 + r] = ((const float*)uniform.value)[r * 4 + c];
+    }
+    for (int i = 0; i < count; ++i) {
+        if (actual[i] != expected[i]) { reportStateMismatch(uniform.name, (long long)expected[i], (long long)actual[i]); return false; }
+    }
+    return true;
+}
+
+// true = precisa enviar; a posição sai em 'location' (-1 se o uniform não existe no programa)
+bool uniformChanged(const char* name, const void* data, int bytes, UniformKind kind, int& location) {
+    CachedUniform* uniform = cachedUniform(name);
+    if (!uniform) { location = glGetUniformLocation(g_glState.program, name); g_frameStats.stateIssued++; return true; }
+    location = uniform->location;
+    if (location < 0) { g_frameStats.stateSkipped++; return false; }
+    if (uniform->bytes == bytes && std::memcmp(uniform->value, data, bytes) == 0 && (!g_glState.validate || validateUniform(*uniform))) {
+        g_frameStats.stateSkipped++;
+        return false;
+    }
+    std::memcpy(uniform->value, data, bytes);
+    uniform->bytes = bytes; uniform->kind = kind;
+    g_frameStats.stateIssued++;
+    return true;
+}
+
+// Uniforms do programa atual (useProgram antes)
+void setUniform1i(const char* name, int v) {
+    int location;
+    if (uniformChanged(name, &v, sizeof(v), UNIFORM_INT, location)) glUniform1i(location, v);
+}
+
+void setUniform3i(const char* name, int x, int y, int z) {
+    int v[3] = { x, y, z }, location;
+    if (uniformChanged(name, v, sizeof(v), UNIFORM_INT, location)) glUniform3iv(location, 1, v);
+}
+
+void setUniform1f(const char* name, float v) {
+    int location;
+    if (uniformChanged(name, &v, sizeof(v), UNIFORM_FLOAT, location)) glUniform1f(location, v);
+}
+
+void setUniform2f(const char* name, float x, float y) {
+    float v[2] = { x, y }; int location;
+    if (uniformChanged(name, v, sizeof(v), UNIFORM_FLOAT, location)) glUniform2fv(location, 1, v);
+}
+
+void setUniform3f(const char* name, const glm::vec3& value) {
+    float v[3] = { value.x, value.y, value.z }; int location;
+    if (uniformChanged(name, v, sizeof(v), UNIFORM_FLOAT, location)) glUniform3fv(location, 1, v);
+}
+
+void setUniform4f(const char* name, float x, float y, float z, float w) {
+    float v[4] = { x, y, z, w }; int location;
+    if (uniformChanged(name, v, sizeof(v), UNIFORM_FLOAT, location)) glUniform4fv(location, 1, v);
+}
+
+void setUniformMatrix4(const char* name, const glm::mat4& m) {
+    int location;
+    if (uniformChanged(name, glm::value_ptr(m), 16 * sizeof(float), UNIFORM_FLOAT, location)) glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(m));
+}
+
+// 3 linhas de 4 floats para um "uniform mat4x3" (transpose = GL_TRUE)
+void setUniformRows4x3(const char* name, const float* rows) {
+    int location;
+    if (uniformChanged(name, rows, 12 * sizeof(float), UNIFORM_ROWS_4x3, location)) glUniformMatrix4x3fv(location, 1, GL_TRUE, rows);
+}
+
+
+// --- RECURSOS DA GPU ---
+// Todo objeto GL de vida longa (buffers, VAOs, programas, texturas, renderbuffers, framebuffers) nasce aqui
+// e ocupa um slot com geração: quem guarda só um GpuHandle descobre se o objeto já foi liberado (gpuName = 0).
+// O dono é um GpuResource (RAII, só move), que passa direto como nome GL. Liberar não apaga na hora: o nome
+// espera até a GPU terminar o frame em que foi solto (uma fence por frame), então nada em voo lê objeto apagado.
+// Cada slot tem categoria e bytes; o relatório (tecla M) soma por categoria e --gpu-budget avisa ao estourar.
+// Queries e fences ficam fora: não ocupam memória que interesse ao orçamento.
+enum GpuResourceKind { GPU_BUFFER, GPU_VERTEX_ARRAY, GPU_PROGRAM, GPU_TEXTURE, GPU_RENDERBUFFER, GPU_FRAMEBUFFER, GPU_KIND_COUNT };
+enum GpuCategory { GPU_CAT_GEOMETRY, GPU_CAT_TEXTURES, GPU_CAT_RENDER_TARGETS, GPU_CAT_FRAME_DATA, GPU_CAT_EFFECTS, GPU_CAT_SHADERS, GPU_CAT_COUNT };
+const char* const g_gpuCategoryNames[GPU_CAT_COUNT] = { "geometria", "texturas", "render targets", "dados por frame", "efeitos", "shaders" };
+const int GPU_FENCE_SLOTS = 4;       // Frames em voo acompanhados (mais que isso: espera a fence mais velha)
+const size_t GPU_STATIC_GEOMETRY_BYTES = 1 << 20;
+
+struct GpuHandle {
+    uint32_t index = 0, generation = 0; // Geração 0 = nulo
+    explicit operator bool() const { return generation != 0; }
+};
+
+struct GpuResourcePool {
+    struct Slot { GpuResourceKind kind; GpuCategory category; unsigned int name; size_t bytes; uint32_t generation; const char* label; bool live; };
+    struct PendingDelete { GpuResourceKind kind; unsigned int name; unsigned long long frame; };
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<PendingDelete> pending;  // Em ordem de frame
+    GLsync fences[GPU_FENCE_SLOTS] = {};
+    unsigned long long fenceFrame[GPU_FENCE_SLOTS] = {};
+    unsigned long long frame = 1, completedFrame = 0;
+    size_t categoryBytes[GPU_CAT_COUNT] = {};
+    int categoryCount[GPU_CAT_COUNT] = {};
+    size_t totalBytes = 0, peakBytes = 0;
+    size_t budgetBytes = (size_t)512 << 20; // --gpu-budget MiB
+    bool overBudget = false;
+    unsigned long long deleted = 0;
+};
+GpuResourcePool g_gpuResources;
+bool g_gpuReportRequest = false; // Tecla M: imprime o relatório de memória no próximo frame
+
+void printGpuMemoryReport() {
+    const GpuResourcePool& pool = g_gpuResources;
+    const double MiB = 1024.0 * 1024.0;
+    std::cout << "--- Memoria da GPU ---" << std::endl << std::fixed << std::setprecision(2);
+    for (int c = 0; c < GPU_CAT_COUNT; ++c)
+        std::cout << "  " << std::left << std::setw(16) << g_gpuCategoryNames[c] << std::right << std::setw(4) << pool.categoryCount[c]
+                  << " objetos " << std::setw(9) << pool.categoryBytes[c] / MiB << " MiB" << std::endl;
+    // Os cinco maiores, para saber o que cortar
+    const GpuResourcePool::Slot* largest[5] = {};
+    for (const GpuResourcePool::Slot& slot : pool.slots) {
+        if (!slot.live) continue;
+        for (int i = 0; i < 5; ++i) {
+            if (largest[i] && largest[i]->bytes >= slot.bytes) continue;
+            for (int j = 4; j > i; --j) largest[j] = largest[j - 1];
+            largest[i] = &slot;
+            break;
+        }
+    }
+    for (const GpuResourcePool::Slot* slot : largest)
+        if (slot && slot->bytes > 0) std::cout << "    " << slot->label << ": " << slot->bytes / MiB << " MiB (" << g_gpuCategoryNames[slot->category] << ")" << std::endl;
+    std::cout << "  Total: " << pool.totalBytes / MiB << " MiB (pico " << pool.peakBytes / MiB << ", orcamento " << pool.budgetBytes / MiB
+              << "), remocoes pendentes " << pool.pending.size() << ", apagados " << pool.deleted << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+unsigned int genGLObject(GpuResourceKind kind) {
+    unsigned int name = 0;
+    switch (kind) {
+        case GPU_BUFFER:       glGenBuffers(1, &name); break;
+        case GPU_VERTEX_ARRAY: glGenVertexArrays(1, &name); break;
+        case GPU_PROGRAM:      name = glCreateProgram(); break;
+        case GPU_TEXTURE:      glGenTextures(1, &name); break;
+        case GPU_RENDERBUFFER: glGenRenderbuffers(1, &name); break;
+        case GPU_FRAMEBUFFER:  glGenFramebuffers(1, &name); break;
+        default: break;
+    }
+    return name;
+}
+
+// Apaga de fato; o GL desliga o objeto onde estiver ligado, então o cache de estado esquece o nome junto
+void deleteGLObject(GpuResourceKind kind, unsigned int name) {
+    GLStateCache& s = g_glState;
+    switch (kind) {
+        case GPU_BUFFER:
+            if (s.arrayBuffer == name) s.arrayBuffer = 0;
+            if (s.textureBuffer == name) s.textureBuffer = 0;
+            if (s.pixelUnpackBuffer == name) s.pixelUnpackBuffer = 0;
+            glDeleteBuffers(1, &name);
+            break;
+        case GPU_VERTEX_ARRAY:
+            if (s.vao == name) s.vao = 0;
+            glDeleteVertexArrays(1, &name);
+            break;
+        case GPU_PROGRAM:
+            // Os uniforms guardados valiam para esse nome; o slot do cache fica livre para outro programa
+            for (int p = 0; p < s.programCount; ++p)
+                if (s.programs[p].program == name) { s.programs[p].program = 0; s.programs[p].count = 0; }
+            glDeleteProgram(name);
+            break;
+        case GPU_TEXTURE:
+            forgetTexture(name);
+            glDeleteTextures(1, &name);
+            break;
+        case GPU_RENDERBUFFER: glDeleteRenderbuffers(1, &name); break;
+        case GPU_FRAMEBUFFER:
+            if (s.framebuffer == name) s.framebuffer = 0;
+            glDeleteFramebuffers(1, &name);
+            break;
+        default: break;
+    }
+    g_gpuResources.deleted++;
+}
+
+GpuHandle gpuCreate(GpuResourceKind kind, GpuCategory category, const char* label) {
+    GpuResourcePool& pool = g_gpuResources;
+    uint32_t index;
+    if (!pool.freeSlots.empty()) { index = pool.freeSlots.back(); pool.freeSlots.pop_back(); }
+    else { index = (uint32_t)pool.slots.size(); pool.slots.push_back(GpuResourcePool::Slot{}); }
+    GpuResourcePool::Slot& slot = pool.slots[index];
+    slot.kind = kind; slot.category = category; slot.label = label;
+    slot.name = genGLObject(kind); slot.bytes = 0; slot.live = true;
+    slot.generation++;
+    if (slot.generation == 0) slot.generation = 1;
+    pool.categoryCount[category]++;
+    GpuHandle handle; handle.index = index; handle.generation = slot.generation;
+    return handle;
+}
+
+GpuResourcePool::Slot* gpuSlot(GpuHandle handle) {
+    GpuResourcePool& pool = g_gpuResources;
+    if (!handle || handle.index >= pool.slots.size()) return nullptr;
+    GpuResourcePool::Slot& slot = pool.slots[handle.index];
+    return slot.live && slot.generation == handle.generation ? &slot : nullptr;
+}
+
+// Nome GL do objeto, ou 0 se o handle é nulo ou já foi liberado
+unsigned int gpuName(GpuHandle handle) {
+    GpuResourcePool::Slot* slot = gpuSlot(handle);
+    return slot ? slot->name : 0;
+}
+
+// Bytes ocupados (chamar a cada glBufferData / glTexImage / glRenderbufferStorage que muda o tamanho)
+void gpuSetBytes(GpuHandle handle, size_t bytes) {
+    GpuResourcePool& pool = g_gpuResources;
+    GpuResourcePool::Slot* slot = gpuSlot(handle);
+    if (!slot || slot->bytes == bytes) return;
+    pool.categoryBytes[slot->category] += bytes - slot->bytes;
+    pool.totalBytes += bytes - slot->bytes;
+    slot->bytes = bytes;
+    pool.peakBytes = std::max(pool.peakBytes, pool.totalBytes);
+    // Avisa uma vez por travessia do limite (e de novo se voltar para baixo e estourar outra vez)
+    bool over = pool.totalBytes > pool.budgetBytes;
+    if (over && !pool.overBudget) {
+        std::cerr << "Aviso: memoria da GPU (" << pool.totalBytes / (1024 * 1024) << " MiB) acima do orcamento de "
+                  << pool.budgetBytes / (1024 * 1024) << " MiB; maior acrescimo: " << slot->label << std::endl;
+        printGpuMemoryReport();
+    }
+    pool.overBudget = over;
+}
+
+// O slot volta a ficar livre na hora (o handle antigo deixa de valer); o nome GL espera a GPU passar do frame atual
+void gpuRelease(GpuHandle handle) {
+    GpuResourcePool& pool = g_gpuResources;
+    GpuResourcePool::Slot* slot = gpuSlot(handle);
+    if (!slot) return;
+    pool.categoryBytes[slot->category] -= slot->bytes;
+    pool.categoryCount[slot->category]--;
+    pool.totalBytes -= slot->bytes;
+    pool.overBudget = pool.totalBytes > pool.budgetBytes;
+    pool.pending.push_back({ slot->kind, slot->name, pool.frame });
+    slot->live = false; slot->name = 0; slot->bytes = 0;
+    pool.freeSlots.push_back(handle.index);
+}
+
+// Dono de um objeto GL: libera (adiado) ao sair de escopo ou em reset(); move-only
+class GpuResource {
+public:
+    GpuResource() = default;
+    GpuResource(GpuResourceKind kind, GpuCategory category, const char* label) : handle(gpuCreate(kind, category, label)), glName(gpuName(handle)) {}
+    ~GpuResource() { reset(); }
+    GpuResource(GpuResource&& other) noexcept : handle(other.handle), glName(other.glName) { other.handle = GpuHandle(); other.glName = 0; }
+    GpuResource& operator=(GpuResource&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = other.handle; glName = other.glName;
+            other.handle = GpuHandle(); other.glName = 0;
+        }
+        return *this;
+    }
+    GpuResource(const GpuResource&) = delete;
+    GpuResource& operator=(const GpuResource&) = delete;
+
+    void reset() {
+        if (handle) gpuRelease(handle);
+        handle = GpuHandle(); glName = 0;
+    }
+    void setBytes(size_t bytes) const { gpuSetBytes(handle, bytes); }
+    GpuHandle get() const { return handle; }
+    unsigned int name() const { return glName; }
+    operator unsigned int() const& { return glName; }
+    operator unsigned int() const&& = delete; // Nome de um temporário, que já teria sido liberado
+private:
+    GpuHandle handle;
+    unsigned int glName = 0;
+};
+
+// Um buffer GL repartido em faixas alinhadas (alocação linear, só na inicialização): menos objetos,
+// e malhas que dividem o buffer dividem também o VAO. As faixas vivem enquanto o arena viver.
+struct GpuBufferArena {
+    GpuResource buffer;
+    size_t capacity = 0, used = 0;
+    const char* label = "";
+};
+struct GpuSlice { unsigned int buffer = 0; size_t offset = 0, size = 0; };
+GpuBufferArena g_staticGeometry; // Malhas da cena e índices do HUD
+
+void createBufferArena(GpuBufferArena& arena, GpuCategory category, size_t capacity, GLenum usage, const char* label) {
+    arena.buffer = GpuResource(GPU_BUFFER, category, label);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, usage);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    arena.buffer.setBytes(capacity);
+    arena.capacity = capacity; arena.used = 0; arena.label = label;
+}
+
+// Faixa de 'size' bytes alinhada a 'alignment' (potência de 2); 'data' opcional é copiado para ela
+GpuSlice suballocate(GpuBufferArena& arena, size_t size, size_t alignment, const void* data = nullptr) {
+    size_t offset = (arena.used + alignment - 1) & ~(alignment - 1);
+    if (offset + size > arena.capacity) {
+        std::cerr << "Arena de buffers '" << arena.label << "' cheio: " << offset + size << " de " << arena.capacity << " bytes" << std::endl;
+        return GpuSlice();
+    }
+    if (data) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    arena.used = offset + size;
+    GpuSlice slice; slice.buffer = arena.buffer.name(); slice.offset = offset; slice.size = size;
+    return slice;
+}
+
+void createGpuResources() {
+    GpuResourcePool& pool = g_gpuResources;
+    // Reservas: criar e liberar durante o jogo (texturas do streaming) não aloca no heap
+    pool.slots.reserve(256); pool.freeSlots.reserve(256); pool.pending.reserve(256);
+    createBufferArena(g_staticGeometry, GPU_CAT_GEOMETRY, GPU_STATIC_GEOMETRY_BYTES, GL_STATIC_DRAW, "geometria estatica");
+}
+
+// Apaga o que estava esperando frames que a GPU já terminou. 'wait': espera tudo (encerramento).
+void collectGpuResources(bool wait) {
+    GpuResourcePool& pool = g_gpuResources;
+    for (int i = 0; i < GPU_FENCE_SLOTS; ++i) {
+        if (!pool.fences[i]) continue;
+        GLenum status = glClientWaitSync(pool.fences[i], 0, wait ? 1000000000ull : 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            pool.completedFrame = std::max(pool.completedFrame, pool.fenceFrame[i]);
+            glDeleteSync(pool.fences[i]);
+            pool.fences[i] = nullptr;
+        }
+    }
+    if (wait) pool.completedFrame = pool.frame;
+    size_t done = 0;
+    while (done < pool.pending.size() && pool.pending[done].frame <= pool.completedFrame) {
+        deleteGLObject(pool.pending[done].kind, pool.pending[done].name);
+        done++;
+    }
+    pool.pending.erase(pool.pending.begin(), pool.pending.begin() + done);
+}
+
+// Fim do frame (depois do swap): fence do frame, se ele soltou algo, e coleta do que já pode ir embora
+void endFrameGpuResources() {
+    GpuResourcePool& pool = g_gpuResources;
+    if (!pool.pending.empty() && pool.pending.back().frame == pool.frame) {
+        int slot = (int)(pool.frame % GPU_FENCE_SLOTS);
+        if (pool.fences[slot]) {
+            // Anel cheio: a fence de GPU_FENCE_SLOTS frames atrás ainda não foi vista; espera ela
+            glClientWaitSync(pool.fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            pool.completedFrame = std::max(pool.completedFrame, pool.fenceFrame[slot]);
+            glDeleteSync(pool.fences[slot]);
+        }
+        pool.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pool.fenceFrame[slot] = pool.frame;
+    }
+    if (!pool.pending.empty()) collectGpuResources(false);
+    pool.frame++;
+    if (g_gpuReportRequest) { printGpuMemoryReport(); g_gpuReportRequest = false; }
+}
+
+// Encerramento: espera a GPU, apaga o que faltava e acusa objetos que ninguém liberou
+void destroyGpuResources() {
+    g_staticGeometry.buffer.reset();
+    collectGpuResources(true);
+    for (GLsync& fence : g_gpuResources.fences) if (fence) { glDeleteSync(fence); fence = nullptr; }
+    int leaked = 0;
+    for (const GpuResourcePool::Slot& slot : g_gpuResources.slots) {
+        if (!slot.live) continue;
+        if (leaked++ < 8) std::cerr << "Recurso da GPU nao liberado: " << slot.label << std::endl;
+        deleteGLObject(slot.kind, slot.name);
+    }
+    if (leaked > 0) std::cerr << leaked << " recurso(s) da GPU nao liberado(s)" << std::endl;
+}
+
+
 // --- SHADERS (Iluminação) ---
 const char* lightingVertexShader = "#version 330 core\n"
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec3 aNormal;\n"
-    "uniform mat4 model;\n uniform mat4 view;\n uniform mat4 projection;\n"
+    "uniform mat4x3 model;\n uniform mat4 view;\n uniform mat4 projection;\n" // model: afim 3x4 empacotada
     "out vec3 FragPos;\n out vec3 Normal;\n"
+    "out vec3 LocalPos;\n out vec3 LocalNormal;\n" // Para texturas presas ao objeto (uniformes)
     "void main()\n"
     "{\n"
-    "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
-    "   FragPos = vec3(model * vec4(aPos, 1.0));\n"
-    "   Normal = mat3(transpose(inverse(model))) * aNormal;\n"
+    "   LocalPos = aPos; LocalNormal = aNormal;\n"
+    "   FragPos = model * vec4(aPos, 1.0);\n"
+    "   gl_Position = projection * view * vec4(FragPos, 1.0);\n"
+    "   Normal = transpose(inverse(mat3(model))) * aNormal;\n"
     "}\0";
-const char* lightingFragmentShader = "#version 330 core\n"
-    "out vec4 FragColor;\n"
+// Cabeçalho dos fragment shaders da cena: cor do objeto por uniform (drawItem) ou vinda do vertex shader (GPU)
+const char* sceneFragmentHeader = "#version 330 core\n uniform vec4 objectColor;\n";
+const char* objectColorVaryingHeader = "#version 330 core\n flat in vec4 objectColor;\n";
+// Iluminação compartilhada pelos fragment shaders da cena (opaco e OIT); cada um só muda a saída
+// Luz principal (lightPos) + luzes pontuais do cluster do fragmento (ver ILUMINAÇÃO EM CLUSTERS)
+const char* lightingFragmentCommon =
     "in vec3 FragPos;\n in vec3 Normal;\n"
-    "uniform vec4 objectColor;\n uniform vec3 lightPos;\n uniform vec3 viewPos;\n"
-    "void main()\n"
+    "in vec3 LocalPos;\n in vec3 LocalNormal;\n"
+    "uniform vec3 lightPos;\n uniform vec3 viewPos;\n"
+    "uniform mat4 view;\n"
+    "uniform sampler2D albedoMap;\n uniform int textureMode;\n uniform float textureScale;\n" // Ver TEXTURAS
+    "uniform samplerBuffer lightData;\n"    // 2 texels por luz: (posição, raio), (cor, intensidade)
+    "uniform usamplerBuffer clusterGrid;\n" // (offset, quantidade) por cluster
+    "uniform usamplerBuffer lightIndices;\n"
+    "uniform ivec3 clusterDims;\n uniform vec4 viewportRect;\n uniform vec2 clusterDepth;\n" // clusterDepth: (near, fatias / log(far/near))
+    "vec3 clusterLights(vec3 norm, vec3 viewDir)\n"
+    "{\n"
+    "   float depth = -(view * vec4(FragPos, 1.0)).z;\n"
+    "   int slice = clamp(int(log(depth / clusterDepth.x) * clusterDepth.y), 0, clusterDims.z - 1);\n"
+    "   ivec2 tile = clamp(ivec2((gl_FragCoord.xy - viewportRect.xy) / viewportRect.zw * vec2(clusterDims.xy)), ivec2(0), clusterDims.xy - 1);\n"
+    "   uvec2 range = texelFetch(clusterGrid, tile.x + clusterDims.x * (tile.y + clusterDims.y * slice)).rg;\n"
+    "   vec3 result = vec3(0.0);\n"
+    "   for (uint i = 0u; i < range.y; ++i) {\n"
+    "       int light = int(texelFetch(lightIndices, int(range.x + i)).r);\n"
+    "       vec4 positionRadius = texelFetch(lightData, light * 2);\n"
+    "       vec4 colorIntensity = texelFetch(lightData, light * 2 + 1);\n"
+    "       vec3 toLight = positionRadius.xyz - FragPos;\n"
+    "       float dist = length(toLight);\n"
+    "       float falloff = clamp(1.0 - dist / positionRadius.w, 0.0, 1.0);\n"
+    "       vec3 dir = toLight / max(dist, 1e-4);\n"
+    "       float diff = max(dot(norm, dir), 0.0);\n"
+    "       float spec = pow(max(dot(viewDir, reflect(-dir, norm)), 0.0), 32);\n"
+    "       result += (diff + 0.5 * spec) * falloff * falloff * colorIntensity.w * colorIntensity.rgb;\n"
+    "   }\n"
+    "   return result;\n"
+    "}\n"
+    // Projeção triplanar (não há coordenadas de textura nas malhas): mundo para cenário, modelo para uniformes
+    "vec3 albedo()\n"
+    "{\n"
+    "   if (textureMode == 0) return vec3(1.0);\n"
+    "   vec3 p = (textureMode == 1 ? FragPos : LocalPos) * textureScale;\n"
+    "   vec3 w = abs(normalize(textureMode == 1 ? Normal : LocalNormal));\n"
+    "   w /= (w.x + w.y + w.z);\n"
+    "   return texture(albedoMap, p.yz).rgb * w.x + texture(albedoMap, p.xz).rgb * w.y + texture(albedoMap, p.xy).rgb * w.z;\n"
+    "}\n"
+    "vec3 shade()\n"
     "{\n"
     "   float ambientStrength = 0.3;\n"
     "   vec3 ambient = ambientStrength * vec3(1.0, 1.0, 1.0);\n"
@@ -123,10 +1069,88 @@ const char* lightingFragmentShader = "#version 330 core\n"
     "   vec3 reflectDir = reflect(-lightDir, norm);\n"
     "   float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);\n"
     "   vec3 specular = specularStrength * spec * vec3(1.0, 1.0, 1.0);\n"
-    "   vec3 result = (ambient + diffuse + specular) * objectColor.rgb;\n"
-    "   FragColor = vec4(result, objectColor.a);\n"
+    "   return (ambient + diffuse + specular + clusterLights(norm, viewDir)) * objectColor.rgb * albedo();\n"
+    "}\n";
+const char* lightingFragmentShader =
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   FragColor = vec4(shade(), objectColor.a);\n"
+    "}\n\0";
+// Weighted blended OIT (McGuire & Bavoil): acumula cor*alpha*peso e o produto de (1 - alpha).
+// Alvo 0: rgb = soma(C*a*w), a = revealage; alvo 1: r = soma(a*w). Blend: (ONE, ONE, ZERO, ONE_MINUS_SRC_ALPHA).
+const char* oitFragmentShader =
+    "layout (location = 0) out vec4 Accum;\n"
+    "layout (location = 1) out vec4 WeightSum;\n"
+    "void main()\n"
+    "{\n"
+    "   float a = objectColor.a;\n"
+    "   float z = gl_FragCoord.z;\n"
+    "   float w = clamp(pow(min(1.0, a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - z * 0.9, 3.0), 1e-2, 3e3);\n"
+    "   Accum = vec4(shade() * a * w, a);\n"
+    "   WeightSum = vec4(a * w);\n"
+    "}\n\0";
+// Triângulo de tela cheia (sem VBO) usado pelos passes de composição
+const char* fullscreenVertexShader = "#version 330 core\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "   gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\0";
+// Resolve do OIT sobre a cor opaca. Blend: (ONE_MINUS_SRC_ALPHA, SRC_ALPHA) => média*(1 - revealage) + fundo*revealage
+const char* oitCompositeFragmentShader = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D accumTexture;\n uniform sampler2D weightTexture;\n"
+    "void main()\n"
+    "{\n"
+    "   ivec2 texel = ivec2(gl_FragCoord.xy);\n"
+    "   vec4 accum = texelFetch(accumTexture, texel, 0);\n"
+    "   float revealage = accum.a;\n"
+    "   if (revealage >= 0.9999) discard;\n"
+    "   vec3 average = accum.rgb / max(texelFetch(weightTexture, texel, 0).r, 1e-5);\n"
+    "   FragColor = vec4(average, revealage);\n"
     "}\n\0";
 
+// Compila um estágio a partir de pedaços de código (o primeiro traz o #version)
+unsigned int compileShader(GLenum type, std::initializer_list<const char*> sources) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, (GLsizei)sources.size(), sources.begin(), NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+unsigned int linkProgram(unsigned int program) {
+    glLinkProgram(program);
+    int linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cerr << "Erro ao linkar shader: " << infoLog << std::endl;
+    }
+    return program;
+}
+
+// Compila e linka um programa. Os fragment shaders da cena são montados com um cabeçalho e lightingFragmentCommon na frente.
+GpuResource compileProgram(std::initializer_list<const char*> vertexSources, std::initializer_list<const char*> fragmentSources) {
+    GpuResource program(GPU_PROGRAM, GPU_CAT_SHADERS, "programa");
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSources);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSources);
+    glAttachShader(program, vertexShader); glAttachShader(program, fragmentShader);
+    linkProgram(program);
+    glDeleteShader(vertexShader); glDeleteShader(fragmentShader);
+    return program;
+}
+
+GpuResource compileComputeProgram(std::initializer_list<const char*> sources) {
+    GpuResource program(GPU_PROGRAM, GPU_CAT_SHADERS, "programa compute");
+    unsigned int computeShader = compileShader(GL_COMPUTE_SHADER, sources);
+    glAttachShader(program, computeShader);
+    linkProgram(program);
+    glDeleteShader(computeShader);
+    return program;
+}
+
 
 void updateCamera() {
     // 1. Trava o ângulo vertical (pitch) para não virar de cabeça para baixo
@@ -142,8 +1166,19 @@ void updateCamera() {
 }
 
 
+// Entrada mais antiga ainda não refletida na tela (glfwGetTime; 0 = nenhuma). Ver LATÊNCIA DE ENTRADA.
+double g_frameInputTime = 0.0;
+
+void noteInput(double time) {
+    if (time > 0.0 && (g_frameInputTime == 0.0 || time < g_frameInputTime)) g_frameInputTime = time;
+}
+
 void processInput(GLFWwindow* window) {
     float cameraSpeed = 0.03f; // Sensibilidade da rotação
+    // O teclado é lido no último glfwPollEvents: é esse o instante da entrada
+    const int cameraKeys[4] = {GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_DOWN};
+    for (int key : cameraKeys)
+        if (glfwGetKey(window, key) == GLFW_PRESS) { noteInput(glfwGetTime()); break; }
 
     // Rotaciona para Esquerda
     if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
@@ -187,6 +1222,7 @@ void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
 
     g_cameraYaw += xOffset;
     g_cameraPitch += yOffset;
+    noteInput(glfwGetTime());
 }
 
 
@@ -194,23 +1230,37 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     float zoomSpeed = 0.5f;
     g_cameraRadius -= yoffset * zoomSpeed;
     g_cameraRadius = glm::clamp(g_cameraRadius, 3.0f, 25.0f); // Limita o zoom
+    noteInput(glfwGetTime());
 }
 
 // --- GEOMETRIA ---
 float cubeVerticesNormals[] = { -0.5f,-0.5f,-0.5f, 0.0f, 0.0f,-1.0f, 0.5f,-0.5f,-0.5f, 0.0f, 0.0f,-1.0f, 0.5f, 0.5f,-0.5f, 0.0f, 0.0f,-1.0f, 0.5f, 0.5f,-0.5f, 0.0f, 0.0f,-1.0f,-0.5f, 0.5f,-0.5f, 0.0f, 0.0f,-1.0f,-0.5f,-0.5f,-0.5f, 0.0f, 0.0f,-1.0f,-0.5f,-0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.5f,-0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f,-0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f,-0.5f,-0.5f, 0.5f, 0.0f, 0.0f, 1.0f,-0.5f, 0.5f, 0.5f,-1.0f, 0.0f, 0.0f,-0.5f, 0.5f,-0.5f,-1.0f, 0.0f, 0.0f,-0.5f,-0.5f,-0.5f,-1.0f, 0.0f, 0.0f,-0.5f,-0.5f,-0.5f,-1.0f, 0.0f, 0.0f,-0.5f,-0.5f, 0.5f,-1.0f, 0.0f, 0.0f,-0.5f, 0.5f, 0.5f,-1.0f, 0.0f, 0.0f, 0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f,-0.5f, 1.0f, 0.0f, 0.0f, 0.5f,-0.5f,-0.5f, 1.0f, 0.0f, 0.0f, 0.5f,-0.5f,-0.5f, 1.0f, 0.0f, 0.0f, 0.5f,-0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f,-0.5f,-0.5f,-0.5f, 0.0f,-1.0f, 0.0f, 0.5f,-0.5f,-0.5f, 0.0f,-1.0f, 0.0f, 0.5f,-0.5f, 0.5f, 0.0f,-1.0f, 0.0f, 0.5f,-0.5f, 0.5f, 0.0f,-1.0f, 0.0f,-0.5f,-0.5f, 0.5f, 0.0f,-1.0f, 0.0f,-0.5f,-0.5f,-0.5f, 0.0f,-1.0f, 0.0f,-0.5f, 0.5f,-0.5f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f,-0.5f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f,-0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f,-0.5f, 0.5f,-0.5f, 0.0f, 1.0f, 0.0f };
-unsigned int createCubeVAO() {
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVerticesNormals), cubeVerticesNormals, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-    return VAO;
+// Todas as malhas moram num único VBO/EBO (ver SceneMeshes): cada uma é uma faixa de índices + vértice base
+struct MeshRange { int firstIndex, indexCount, baseVertex; };
+struct MeshData {
+    std::vector<float> vertices; // posição + normal
+    std::vector<unsigned int> indices;
+};
+
+MeshRange beginMesh(const MeshData& data) {
+    return { (int)data.indices.size(), 0, (int)(data.vertices.size() / 6) };
+}
+
+void endMesh(const MeshData& data, MeshRange& range) {
+    range.indexCount = (int)data.indices.size() - range.firstIndex;
+}
+
+MeshRange appendCubeMesh(MeshData& data) {
+    MeshRange range = beginMesh(data);
+    data.vertices.insert(data.vertices.end(), std::begin(cubeVerticesNormals), std::end(cubeVerticesNormals));
+    for (unsigned int i = 0; i < 36; ++i) data.indices.push_back(i);
+    endMesh(data, range);
+    return range;
 }
-std::pair<unsigned int, int> createSphereVAO(float radius, int sectors, int stacks) {
-    std::vector<float> vertices; std::vector<unsigned int> indices;
+MeshRange appendSphereMesh(MeshData& data, float radius, int sectors, int stacks) {
+    MeshRange range = beginMesh(data);
+    std::vector<float>& vertices = data.vertices; std::vector<unsigned int>& indices = data.indices;
+    vertices.reserve(vertices.size() + (stacks + 1) * (sectors + 1) * 6); indices.reserve(indices.size() + stacks * sectors * 6);
     float x, y, z, xy, nx, ny, nz, lengthInv = 1.0f / radius;
     float stackStep = PI / stacks, sectorStep = 2 * PI / sectors, stackAngle, sectorAngle;
     for (int i = 0; i <= stacks; ++i) {
@@ -230,37 +1280,31 @@ std::pair<unsigned int, int> createSphereVAO(float radius, int sectors, int stac
             if (i != (stacks - 1)) { indices.push_back(k1 + 1); indices.push_back(k2); indices.push_back(k2 + 1); }
         }
     }
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO); glGenBuffers(1, &EBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-    return {VAO, (int)indices.size()};
+    endMesh(data, range);
+    return range;
 }
 // NOVO: FUNÇÃO PARA CRIAR CILINDRO
-std::pair<unsigned int, int> createCylinderVAO(float radius, float height, int sectors) {
-    std::vector<float> vertices; std::vector<unsigned int> indices;
+MeshRange appendCylinderMesh(MeshData& data, float radius, float height, int sectors) {
+    MeshRange range = beginMesh(data);
+    std::vector<float>& vertices = data.vertices; std::vector<unsigned int>& indices = data.indices;
+    size_t firstVertex = vertices.size();
+    vertices.reserve(vertices.size() + (4 * (sectors + 1) + 2) * 6); indices.reserve(indices.size() + sectors * 12);
     float halfHeight = height / 2.0f; float sectorStep = 2 * PI / sectors; float sectorAngle;
     for (int i = 0; i <= sectors; ++i) {
         sectorAngle = i * sectorStep; float x = radius * cos(sectorAngle); float z = radius * sin(sectorAngle);
         vertices.push_back(x); vertices.push_back( halfHeight); vertices.push_back(z); vertices.push_back(x/radius); vertices.push_back(0.0f); vertices.push_back(z/radius);
         vertices.push_back(x); vertices.push_back(-halfHeight); vertices.push_back(z); vertices.push_back(x/radius); vertices.push_back(0.0f); vertices.push_back(z/radius);
     }
-    int topCenterIndex = vertices.size() / 6;
+    int topCenterIndex = (vertices.size() - firstVertex) / 6;
     vertices.push_back(0.0f); vertices.push_back( halfHeight); vertices.push_back(0.0f); vertices.push_back(0.0f); vertices.push_back( 1.0f); vertices.push_back(0.0f);
-    int bottomCenterIndex = vertices.size() / 6;
+    int bottomCenterIndex = (vertices.size() - firstVertex) / 6;
     vertices.push_back(0.0f); vertices.push_back(-halfHeight); vertices.push_back(0.0f); vertices.push_back(0.0f); vertices.push_back(-1.0f); vertices.push_back(0.0f);
-    int topCapStartIndex = vertices.size() / 6;
+    int topCapStartIndex = (vertices.size() - firstVertex) / 6;
      for (int i = 0; i <= sectors; ++i) {
         sectorAngle = i * sectorStep; float x = radius * cos(sectorAngle); float z = radius * sin(sectorAngle);
         vertices.push_back(x); vertices.push_back( halfHeight); vertices.push_back(z); vertices.push_back(0.0f); vertices.push_back( 1.0f); vertices.push_back(0.0f);
      }
-    int bottomCapStartIndex = vertices.size() / 6;
+    int bottomCapStartIndex = (vertices.size() - firstVertex) / 6;
      for (int i = 0; i <= sectors; ++i) {
         sectorAngle = i * sectorStep; float x = radius * cos(sectorAngle); float z = radius * sin(sectorAngle);
         vertices.push_back(x); vertices.push_back(-halfHeight); vertices.push_back(z); vertices.push_back(0.0f); vertices.push_back(-1.0f); vertices.push_back(0.0f);
@@ -272,51 +1316,230 @@ std::pair<unsigned int, int> createCylinderVAO(float radius, float height, int s
     }
     for (int i = 0; i < sectors; ++i) { indices.push_back(topCenterIndex); indices.push_back(topCapStartIndex + i); indices.push_back(topCapStartIndex + i + 1); }
     for (int i = 0; i < sectors; ++i) { indices.push_back(bottomCenterIndex); indices.push_back(bottomCapStartIndex + i + 1); indices.push_back(bottomCapStartIndex + i); }
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO); glGenBuffers(1, &VBO); glGenBuffers(1, &EBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
-    return {VAO, (int)indices.size()};
+    endMesh(data, range);
+    return range;
+}
+
+
+
+// --- TRANSFORMAÇÃO AFIM 3x4 ---
+// Toda matriz de modelo da cena é afim: guardamos só as 3 primeiras linhas [R*S | t]
+// (a linha (0,0,0,1) fica implícita). A composição usa SSE quando disponível e o
+// upload vai direto para um mat4x3 no shader (48 bytes em vez de 64).
+struct alignas(16) Affine3x4 {
+    float m[3][4]; // m[linha][coluna]; a coluna 3 é a translação
+};
+
+inline Affine3x4 affineIdentity() {
+    Affine3x4 r = {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}}};
+    return r;
+}
+inline Affine3x4 affineTranslation(const glm::vec3& t) {
+    Affine3x4 r = affineIdentity();
+    r.m[0][3] = t.x; r.m[1][3] = t.y; r.m[2][3] = t.z;
+    return r;
+}
+// Mesma convenção de glm::rotate (ângulo em radianos, regra da mão direita)
+inline Affine3x4 affineRotation(float angle, const glm::vec3& axisIn) {
+    glm::vec3 a = glm::normalize(axisIn);
+    float c = cos(angle), s = sin(angle);
+    glm::vec3 t = a * (1.0f - c);
+    Affine3x4 r = {{{c + t.x * a.x,       t.y * a.x - s * a.z, t.z * a.x + s * a.y, 0.0f},
+                    {t.x * a.y + s * a.z, c + t.y * a.y,       t.z * a.y - s * a.x, 0.0f},
+                    {t.x * a.z - s * a.y, t.y * a.z + s * a.x, c + t.z * a.z,       0.0f}}};
+    return r;
+}
+inline Affine3x4 affineFromMat4(const glm::mat4& m) {
+    Affine3x4 r;
+    for (int i = 0; i < 3; ++i) for (int j = 0; j < 4; ++j) r.m[i][j] = m[j][i];
+    return r;
+}
+inline glm::mat4 affineToMat4(const Affine3x4& a) {
+    glm::mat4 r(1.0f);
+    for (int i = 0; i < 3; ++i) for (int j = 0; j < 4; ++j) r[j][i] = a.m[i][j];
+    return r;
+}
+inline glm::vec3 affineTransformPoint(const Affine3x4& a, const glm::vec3& p) {
+    return glm::vec3(a.m[0][0] * p.x + a.m[0][1] * p.y + a.m[0][2] * p.z + a.m[0][3],
+                     a.m[1][0] * p.x + a.m[1][1] * p.y + a.m[1][2] * p.z + a.m[1][3],
+                     a.m[2][0] * p.x + a.m[2][1] * p.y + a.m[2][2] * p.z + a.m[2][3]);
+}
+
+// r = a * b
+inline Affine3x4 affineMul(const Affine3x4& a, const Affine3x4& b) {
+    Affine3x4 r;
+#ifdef AFFINE_SSE
+    __m128 b0 = _mm_load_ps(b.m[0]), b1 = _mm_load_ps(b.m[1]), b2 = _mm_load_ps(b.m[2]);
+    const __m128 w = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f); // Linha implícita (0,0,0,1)
+    for (int i = 0; i < 3; ++i) {
+        __m128 row = _mm_load_ps(a.m[i]);
+        __m128 out = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+        out = _mm_add_ps(out, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), w));
+        _mm_store_ps(r.m[i], out);
+    }
+#else
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+        }
+        r.m[i][3] += a.m[i][3];
+    }
+#endif
+    return r;
+}
+
+// Equivalentes de glm::translate/scale/rotate (pós-multiplicam a transformação atual),
+// mas tocando só nas colunas que mudam
+inline Affine3x4 affineTranslate(const Affine3x4& a, const glm::vec3& v) {
+    Affine3x4 r = a;
+    for (int i = 0; i < 3; ++i) r.m[i][3] += a.m[i][0] * v.x + a.m[i][1] * v.y + a.m[i][2] * v.z;
+    return r;
+}
+inline Affine3x4 affineScale(const Affine3x4& a, const glm::vec3& v) {
+    Affine3x4 r = a;
+    for (int i = 0; i < 3; ++i) { r.m[i][0] *= v.x; r.m[i][1] *= v.y; r.m[i][2] *= v.z; }
+    return r;
+}
+// Rotação em torno de um eixo canônico: mistura as duas colunas do plano de rotação
+inline Affine3x4 affineRotateAxis(const Affine3x4& a, float angle, int colA, int colB) {
+    if (angle == 0.0f) return a;
+    float c = cos(angle), s = sin(angle);
+    Affine3x4 r = a;
+    for (int i = 0; i < 3; ++i) {
+        r.m[i][colA] = a.m[i][colA] * c + a.m[i][colB] * s;
+        r.m[i][colB] = a.m[i][colB] * c - a.m[i][colA] * s;
+    }
+    return r;
+}
+inline Affine3x4 affineRotateX(const Affine3x4& a, float angle) { return affineRotateAxis(a, angle, 1, 2); }
+inline Affine3x4 affineRotateY(const Affine3x4& a, float angle) { return affineRotateAxis(a, angle, 2, 0); }
+inline Affine3x4 affineRotateZ(const Affine3x4& a, float angle) { return affineRotateAxis(a, angle, 0, 1); }
+
+// Base ortonormal com o eixo Y apontando para 'direction' (para cilindros, que são simétricos em Y;
+// dispensa o acos/cross de montar uma rotação eixo-ângulo)
+inline Affine3x4 affineAlignY(const glm::vec3& center, const glm::vec3& direction) {
+    glm::vec3 y = glm::normalize(direction);
+    glm::vec3 helper = std::abs(y.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec3 z = glm::normalize(glm::cross(helper, y));
+    glm::vec3 x = glm::cross(y, z);
+    Affine3x4 r = {{{x.x, y.x, z.x, center.x}, {x.y, y.y, z.y, center.y}, {x.z, y.z, z.z, center.z}}};
+    return r;
+}
+
+// Composição em lote: out[r * partCount + p] = bases[r] * parts[p].
+// Os coeficientes de cada base são espalhados uma vez e reaproveitados em todas as partes do rig.
+void affineComposeRigs(const Affine3x4* bases, int rigCount, const Affine3x4* parts, int partCount, Affine3x4* out) {
+#ifdef AFFINE_SSE
+    const __m128 w = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    for (int r = 0; r < rigCount; ++r) {
+        __m128 coef[3][4];
+        for (int i = 0; i < 3; ++i) {
+            __m128 row = _mm_load_ps(bases[r].m[i]);
+            coef[i][0] = _mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0));
+            coef[i][1] = _mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1));
+            coef[i][2] = _mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2));
+            coef[i][3] = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), w);
+        }
+        Affine3x4* dst = out + (size_t)r * partCount;
+        for (int p = 0; p < partCount; ++p) {
+            __m128 p0 = _mm_load_ps(parts[p].m[0]), p1 = _mm_load_ps(parts[p].m[1]), p2 = _mm_load_ps(parts[p].m[2]);
+            for (int i = 0; i < 3; ++i) {
+                __m128 o = _mm_add_ps(_mm_mul_ps(coef[i][0], p0), _mm_mul_ps(coef[i][1], p1));
+                o = _mm_add_ps(o, _mm_add_ps(_mm_mul_ps(coef[i][2], p2), coef[i][3]));
+                _mm_store_ps(dst[p].m[i], o);
+            }
+        }
+    }
+#else
+    for (int r = 0; r < rigCount; ++r)
+        for (int p = 0; p < partCount; ++p) out[(size_t)r * partCount + p] = affineMul(bases[r], parts[p]);
+#endif
+}
+
+// Upload empacotado: 3 linhas de 4 floats para o "uniform mat4x3 model" (transpose = GL_TRUE)
+void uploadModel(const Affine3x4& model) {
+    setUniformRows4x3("model", &model.m[0][0]);
 }
 
 
+// --- LISTA DE DESENHO ---
+// As funções draw* não falam com o OpenGL: só anotam itens na lista do frame.
+// A lista é montada uma vez por frame e depois submetida para cada câmera, que refaz apenas
+// o culling e a submissão (ver submitView).
+enum MeshType { MESH_CUBE, MESH_SPHERE, MESH_CYLINDER, MESH_COUNT };
+enum Material { MAT_NONE, MAT_GRASS, MAT_CONCRETE, MAT_KIT_1, MAT_KIT_2, MAT_COUNT }; // Ver TEXTURAS
+
+struct DrawItem {
+    Affine3x4 model;
+    glm::vec4 color;
+    glm::vec4 bounds; // Esfera envolvente em mundo (centro xyz, raio w) para o culling por câmera
+    MeshType mesh;
+    Material material;
+    bool occluder;    // Entra no rasterizador de oclusão (ver OCLUSÃO)
+};
+typedef FrameVector<DrawItem> DrawList;
+thread_local DrawList* g_drawList = nullptr; // Lista sendo montada por buildScene
+thread_local Material g_drawMaterial = MAT_NONE; // Material corrente para drawCube/drawSphere/drawCylinder
+thread_local bool g_drawOccluder = false;        // Idem: marca os itens como oclusores
+
+// Raio da esfera envolvente de cada malha no espaço do modelo (cubo unitário, esfera e cilindro de raio 1)
+const float g_meshLocalRadius[MESH_COUNT] = {0.8661f, 1.0f, 1.1181f};
+
+void addDrawItem(const Affine3x4& model, const glm::vec4& color, MeshType mesh, Material material) {
+    float maxScale2 = 0.0f;
+    for (int j = 0; j < 3; ++j) {
+        float len2 = model.m[0][j] * model.m[0][j] + model.m[1][j] * model.m[1][j] + model.m[2][j] * model.m[2][j];
+        maxScale2 = std::max(maxScale2, len2);
+    }
+    DrawItem item;
+    item.model = model; item.color = color; item.mesh = mesh; item.material = material; item.occluder = g_drawOccluder;
+    item.bounds = glm::vec4(model.m[0][3], model.m[1][3], model.m[2][3], std::sqrt(maxScale2) * g_meshLocalRadius[mesh]);
+    g_drawList->push_back(item);
+}
+
 
 // --- FUNÇÕES DE DESENHO BASE ---
-void drawCube(unsigned int shaderProgram, glm::mat4 model, glm::vec4 color) {
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), color.r, color.g, color.b, color.a);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+void drawCube(const Affine3x4& model, glm::vec4 color) {
+    addDrawItem(model, color, MESH_CUBE, g_drawMaterial);
+}
+void drawCube(glm::mat4 model, glm::vec4 color) {
+    drawCube(affineFromMat4(model), color);
+}
+void drawSphere(const Affine3x4& model, glm::vec4 color) {
+    addDrawItem(model, color, MESH_SPHERE, g_drawMaterial);
 }
-void drawSphere(unsigned int shaderProgram, unsigned int sphereVAO, int indexCount, glm::mat4 model, glm::vec4 color) {
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), color.r, color.g, color.b, color.a);
-    glBindVertexArray(sphereVAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+void drawSphere(glm::mat4 model, glm::vec4 color) {
+    drawSphere(affineFromMat4(model), color);
 }
 // NOVO: FUNÇÃO PARA DESENHAR CILINDRO
-void drawCylinder(unsigned int shaderProgram, unsigned int cylinderVAO, int indexCount, glm::mat4 model, float height, float radius, glm::vec4 color) {
-    model = glm::scale(model, glm::vec3(radius, height, radius));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), color.r, color.g, color.b, color.a);
-    glBindVertexArray(cylinderVAO);
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+void drawCylinder(const Affine3x4& model, float height, float radius, glm::vec4 color) {
+    addDrawItem(affineScale(model, glm::vec3(radius, height, radius)), color, MESH_CYLINDER, g_drawMaterial);
 }
 
-void drawPlayer(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sphereVAO, int sphereIndexCount, glm::vec3 position, Team team) {
-    glm::mat4 baseTransform = glm::translate(glm::mat4(1.0f), position);
-    glm::vec3 direction = g_ballPosition - position;
-    float angleY = atan2(direction.x, direction.z);
-    baseTransform = glm::rotate(baseTransform, angleY, glm::vec3(0.0f, 1.0f, 0.0f));
+// --- RIG DO JOGADOR ---
+// As partes do corpo ficam no espaço local do jogador; a base (posição + giro para a bola)
+// é aplicada depois, o que permite compor vários rigs iguais de uma vez (torcida).
+const int MAX_RIG_PARTS = 16;
+struct PlayerRig {
+    Affine3x4 transforms[MAX_RIG_PARTS];
+    glm::vec4 colors[MAX_RIG_PARTS];
+    MeshType meshes[MAX_RIG_PARTS];
+    Material materials[MAX_RIG_PARTS];
+    int count = 0;
+
+    void add(const Affine3x4& transform, const glm::vec4& color, MeshType mesh, Material material = MAT_NONE) {
+        transforms[count] = transform; colors[count] = color; meshes[count] = mesh; materials[count] = material; count++;
+    }
+};
 
+void buildPlayerRig(GameState state, float animationTimer, Team team, PlayerRig& rig) {
+    rig.count = 0;
     glm::vec4 color1, color2;
     if (team == TEAM_1) { color1 = g_team1Color1; color2 = g_team1Color2; }
     else { color1 = g_team2Color1; color2 = g_team2Color2; }
+    Material kit = (team == TEAM_1) ? MAT_KIT_1 : MAT_KIT_2;
 
     // --- Lógica de Animação Atualizada ---
     float runAngle = 0.0f;
@@ -324,102 +1547,99 @@ void drawPlayer(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int s
     float jumpOffset = 0.0f;     // Para o pulo da comemoração
     float armRaiseAngle = 0.0f;  // Para levantar os braços
 
-    if (g_gameState == STATE_RUNNING_UP) { 
-        runAngle = sin(g_animationTimer * 10.0f); 
+    if (state == STATE_RUNNING_UP) { 
+        runAngle = sin(animationTimer * 10.0f); 
     }
-    else if (g_gameState == STATE_KICKING) {
-        float kickProgress = std::min(1.0f, g_animationTimer / 0.3f);
+    else if (state == STATE_KICKING) {
+        float kickProgress = std::min(1.0f, animationTimer / 0.3f);
         if(kickProgress < 0.66f) { kickAngle = glm::mix(0.0f, glm::radians(-90.0f), kickProgress / 0.66f); }
         else { kickAngle = glm::mix(glm::radians(-90.0f), glm::radians(30.0f), (kickProgress - 0.66f) / 0.34f); }
     }
-    else if (g_gameState == STATE_CELEBRATING) {
+    else if (state == STATE_CELEBRATING) {
         // Pulo: abs(sin(...)) cria um movimento de "pulo" contínuo
-        jumpOffset = abs(sin(g_animationTimer * 8.0f)) * 0.4f; 
+        jumpOffset = abs(sin(animationTimer * 8.0f)) * 0.4f; 
         // Braços para cima: Gira -135 graus no eixo X
         armRaiseAngle = glm::radians(-135.0f); 
     }
     // --- Fim da Lógica de Animação ---
 
     // Aplica o pulo (se estiver comemorando)
-    baseTransform = glm::translate(baseTransform, glm::vec3(0.0f, jumpOffset, 0.0f));
+    Affine3x4 baseTransform = affineTranslation(glm::vec3(0.0f, jumpOffset, 0.0f));
 
-    // --- Desenho do Corpo ---
+    // --- Corpo ---
     glm::vec3 torsoSize = g_playerTorsoSize; glm::vec3 limbSize = g_playerLimbSize; float headRadius = g_playerHeadRadius;
     glm::vec3 neckSize(headRadius * 0.5f, 0.1f, headRadius * 0.5f);
     glm::vec3 handSize(limbSize.x * 0.8f, limbSize.x * 0.8f, limbSize.x * 0.8f);
     glm::vec3 footSize(limbSize.x * 1.1f, 0.15f, limbSize.z * 1.8f);
     int numStripes = 4; float stripeHeight = torsoSize.y / numStripes; glm::vec3 stripeSize = glm::vec3(torsoSize.x, stripeHeight, torsoSize.z);
     
-    glBindVertexArray(cubeVAO);
     for (int i = 0; i < numStripes; ++i) {
         float yOffset = -torsoSize.y/2.0f + stripeHeight / 2.0f + i * stripeHeight;
-        glm::mat4 torsoModel = glm::scale(glm::translate(baseTransform, glm::vec3(0.0f, yOffset, 0.0f)), stripeSize);
-        glm::vec4 color = (i % 2 == 0) ? color1 : color2; drawCube(shaderProgram, torsoModel, color);
+        glm::vec4 color = (i % 2 == 0) ? color1 : color2;
+        rig.add(affineScale(affineTranslate(baseTransform, glm::vec3(0.0f, yOffset, 0.0f)), stripeSize), color, MESH_CUBE, kit);
     }
-    glm::mat4 neckModel_base = glm::translate(baseTransform, glm::vec3(0.0f, torsoSize.y / 2.0f, 0.0f));
-    glm::mat4 neckModel_final = glm::scale(glm::translate(neckModel_base, glm::vec3(0.0f, neckSize.y / 2.0f, 0.0f)), neckSize);
-    drawCube(shaderProgram, neckModel_final, g_skinColor);
-    
-    glm::mat4 headModel = glm::scale(glm::translate(neckModel_base, glm::vec3(0.0f, neckSize.y + headRadius * 0.8f, 0.0f)), glm::vec3(headRadius));
-    drawSphere(shaderProgram, sphereVAO, sphereIndexCount, headModel, g_skinColor);
+    Affine3x4 neckModel_base = affineTranslate(baseTransform, glm::vec3(0.0f, torsoSize.y / 2.0f, 0.0f));
+    rig.add(affineScale(affineTranslate(neckModel_base, glm::vec3(0.0f, neckSize.y / 2.0f, 0.0f)), neckSize), g_skinColor, MESH_CUBE);
+    rig.add(affineScale(affineTranslate(neckModel_base, glm::vec3(0.0f, neckSize.y + headRadius * 0.8f, 0.0f)), glm::vec3(headRadius)), g_skinColor, MESH_SPHERE);
     
-    glBindVertexArray(cubeVAO);
-    glm::mat4 coxaEsqModel_base = glm::translate(baseTransform, glm::vec3(-0.15f, -torsoSize.y/2.0f, 0.0f));
-    coxaEsqModel_base = glm::rotate(coxaEsqModel_base, glm::radians(30.0f) * -runAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 coxaEsqModel_final = glm::scale(glm::translate(coxaEsqModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, coxaEsqModel_final, g_shortsColor);
-    
-    // ... (código da canela e pé esquerdo) ...
-    glm::mat4 canelaEsqModel_base = glm::translate(coxaEsqModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
-    canelaEsqModel_base = glm::rotate(canelaEsqModel_base, glm::radians(20.0f) * std::max(0.0f, -runAngle), glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 canelaEsqModel_final = glm::scale(glm::translate(canelaEsqModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, canelaEsqModel_final, g_shortsColor);
-    glm::mat4 peEsqModel_base = glm::translate(canelaEsqModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f)); 
-    glm::mat4 peEsqModel_final = glm::scale(glm::translate(peEsqModel_base, glm::vec3(0.0f, -footSize.y / 2.0f, footSize.z / 3.0f)), footSize);
-    drawCube(shaderProgram, peEsqModel_final, glm::vec4(0.9f, 0.9f, 0.9f, 1.0f)); 
-
-    glm::mat4 coxaDirModel_base = glm::translate(baseTransform, glm::vec3(0.15f, -torsoSize.y/2.0f, 0.0f));
-    float legAngle = (g_gameState == STATE_KICKING) ? kickAngle : (glm::radians(30.0f) * runAngle);
-    coxaDirModel_base = glm::rotate(coxaDirModel_base, legAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 coxaDirModel_final = glm::scale(glm::translate(coxaDirModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, coxaDirModel_final, g_shortsColor);
-
-    // ... (código da canela e pé direito) ...
-    glm::mat4 canelaDirModel_base = glm::translate(coxaDirModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
-    float kneeAngle = (g_gameState == STATE_KICKING) ? std::max(0.0f, -kickAngle * 0.5f) : (glm::radians(20.0f) * std::max(0.0f, runAngle));
-    canelaDirModel_base = glm::rotate(canelaDirModel_base, kneeAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 canelaDirModel_final = glm::scale(glm::translate(canelaDirModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, canelaDirModel_final, g_shortsColor);
-    glm::mat4 peDirModel_base = glm::translate(canelaDirModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
-    glm::mat4 peDirModel_final = glm::scale(glm::translate(peDirModel_base, glm::vec3(0.0f, -footSize.y / 2.0f, footSize.z / 3.0f)), footSize);
-    drawCube(shaderProgram, peDirModel_final, glm::vec4(0.9f, 0.9f, 0.9f, 1.0f));
+    // Perna esquerda (coxa, canela e pé)
+    Affine3x4 coxaEsqModel_base = affineTranslate(baseTransform, glm::vec3(-0.15f, -torsoSize.y/2.0f, 0.0f));
+    coxaEsqModel_base = affineRotateX(coxaEsqModel_base, glm::radians(30.0f) * -runAngle);
+    rig.add(affineScale(affineTranslate(coxaEsqModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize), g_shortsColor, MESH_CUBE);
+    Affine3x4 canelaEsqModel_base = affineTranslate(coxaEsqModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
+    canelaEsqModel_base = affineRotateX(canelaEsqModel_base, glm::radians(20.0f) * std::max(0.0f, -runAngle));
+    rig.add(affineScale(affineTranslate(canelaEsqModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize), g_shortsColor, MESH_CUBE);
+    Affine3x4 peEsqModel_base = affineTranslate(canelaEsqModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f)); 
+    rig.add(affineScale(affineTranslate(peEsqModel_base, glm::vec3(0.0f, -footSize.y / 2.0f, footSize.z / 3.0f)), footSize), glm::vec4(0.9f, 0.9f, 0.9f, 1.0f), MESH_CUBE);
 
-    // --- (ATUALIZADO) Braços ---
-    glm::mat4 bracoEsqModel_base = glm::translate(baseTransform, glm::vec3(-torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f));
-    bracoEsqModel_base = glm::rotate(bracoEsqModel_base, armRaiseAngle, glm::vec3(1.0f, 0.0f, 0.0f)); // <-- Aplicando rotação da comemoração
-    bracoEsqModel_base = glm::rotate(bracoEsqModel_base, glm::radians(30.0f) * runAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 bracoEsqModel_final = glm::scale(glm::translate(bracoEsqModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, bracoEsqModel_final, color1);
-    
-    // ... (mão esquerda) ...
-    glm::mat4 maoEsqModel_base = glm::translate(bracoEsqModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y, 0.0f));
-    glm::mat4 maoEsqModel_final = glm::scale(glm::translate(maoEsqModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize);
-    drawCube(shaderProgram, maoEsqModel_final, g_skinColor);
+    // Perna direita (a do chute)
+    Affine3x4 coxaDirModel_base = affineTranslate(baseTransform, glm::vec3(0.15f, -torsoSize.y/2.0f, 0.0f));
+    float legAngle = (state == STATE_KICKING) ? kickAngle : (glm::radians(30.0f) * runAngle);
+    coxaDirModel_base = affineRotateX(coxaDirModel_base, legAngle);
+    rig.add(affineScale(affineTranslate(coxaDirModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize), g_shortsColor, MESH_CUBE);
+    Affine3x4 canelaDirModel_base = affineTranslate(coxaDirModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
+    float kneeAngle = (state == STATE_KICKING) ? std::max(0.0f, -kickAngle * 0.5f) : (glm::radians(20.0f) * std::max(0.0f, runAngle));
+    canelaDirModel_base = affineRotateX(canelaDirModel_base, kneeAngle);
+    rig.add(affineScale(affineTranslate(canelaDirModel_base, glm::vec3(0.0f, -limbSize.y/2.0f, 0.0f)), limbSize), g_shortsColor, MESH_CUBE);
+    Affine3x4 peDirModel_base = affineTranslate(canelaDirModel_base, glm::vec3(0.0f, -limbSize.y, 0.0f));
+    rig.add(affineScale(affineTranslate(peDirModel_base, glm::vec3(0.0f, -footSize.y / 2.0f, footSize.z / 3.0f)), footSize), glm::vec4(0.9f, 0.9f, 0.9f, 1.0f), MESH_CUBE);
 
-    glm::mat4 bracoDirModel_base = glm::translate(baseTransform, glm::vec3(torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f));
-    bracoDirModel_base = glm::rotate(bracoDirModel_base, armRaiseAngle, glm::vec3(1.0f, 0.0f, 0.0f)); // <-- Aplicando rotação da comemoração
-    bracoDirModel_base = glm::rotate(bracoDirModel_base, glm::radians(30.0f) * -runAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 bracoDirModel_final = glm::scale(glm::translate(bracoDirModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y/2.0f, 0.0f)), limbSize);
-    drawCube(shaderProgram, bracoDirModel_final, color1);
+    // --- (ATUALIZADO) Braços ---
+    Affine3x4 bracoEsqModel_base = affineTranslate(baseTransform, glm::vec3(-torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f));
+    bracoEsqModel_base = affineRotateX(bracoEsqModel_base, armRaiseAngle + glm::radians(30.0f) * runAngle); // Comemoração + corrida
+    rig.add(affineScale(affineTranslate(bracoEsqModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y/2.0f, 0.0f)), limbSize), color1, MESH_CUBE, kit);
+    Affine3x4 maoEsqModel_base = affineTranslate(bracoEsqModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y, 0.0f));
+    rig.add(affineScale(affineTranslate(maoEsqModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize), g_skinColor, MESH_CUBE);
 
-    // ... (mão direita) ...
-    glm::mat4 maoDirModel_base = glm::translate(bracoDirModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y, 0.0f));
-    glm::mat4 maoDirModel_final = glm::scale(glm::translate(maoDirModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize);
-    drawCube(shaderProgram, maoDirModel_final, g_skinColor);
+    Affine3x4 bracoDirModel_base = affineTranslate(baseTransform, glm::vec3(torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f));
+    bracoDirModel_base = affineRotateX(bracoDirModel_base, armRaiseAngle + glm::radians(30.0f) * -runAngle);
+    rig.add(affineScale(affineTranslate(bracoDirModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y/2.0f, 0.0f)), limbSize), color1, MESH_CUBE, kit);
+    Affine3x4 maoDirModel_base = affineTranslate(bracoDirModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y, 0.0f));
+    rig.add(affineScale(affineTranslate(maoDirModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize), g_skinColor, MESH_CUBE);
 }
 
-void drawKeeper(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sphereVAO, int sphereIndexCount, glm::vec3 position, glm::vec4 color) {
-    glm::mat4 baseTransform = glm::translate(glm::mat4(1.0f), glm::vec3(position.x, g_keeperPosition.y, position.z));
+// Posição no campo + giro em Y para o jogador olhar para a bola
+Affine3x4 playerBaseTransform(glm::vec3 position) {
+    glm::vec3 direction = g_ballPosition - position;
+    return affineRotateY(affineTranslation(position), atan2(direction.x, direction.z));
+}
+
+// Desenha as partes de um rig já compostas em espaço de mundo
+void drawRigParts(const PlayerRig& rig, const Affine3x4* world) {
+    for (int i = 0; i < rig.count; ++i) addDrawItem(world[i], rig.colors[i], rig.meshes[i], rig.materials[i]);
+}
+
+void drawPlayer(glm::vec3 position, Team team) {
+    PlayerRig rig;
+    buildPlayerRig(g_gameState, g_animationTimer, team, rig);
+    Affine3x4 base = playerBaseTransform(position);
+    Affine3x4 world[MAX_RIG_PARTS];
+    affineComposeRigs(&base, 1, rig.transforms, rig.count, world);
+    drawRigParts(rig, world);
+}
+
+void drawKeeper(glm::vec3 position, glm::vec4 color) {
+    Affine3x4 baseTransform = affineTranslation(glm::vec3(position.x, g_keeperPosition.y, position.z));
     float diveRotationZ = 0.0f; float armRotationX = 0.0f; float armRotationY = 0.0f; float jumpY = 0.0f; bool stayMiddle = false;
     if (g_keeperState == KEEPER_DIVING) {
         float totalDist = abs(g_keeperTargetPos.x - g_keeperPosition.x); float diveProgress = 0.0f;
@@ -434,75 +1654,69 @@ void drawKeeper(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int s
             armRotationX = glm::mix(0.0f, glm::radians(-90.0f), sin(diveProgress * PI)); // Estica para frente
         }
     }
-    baseTransform = glm::translate(baseTransform, glm::vec3(0.0f, jumpY, 0.0f));
-    baseTransform = glm::rotate(baseTransform, diveRotationZ, glm::vec3(0.0f, 0.0f, 1.0f));
+    baseTransform = affineTranslate(baseTransform, glm::vec3(0.0f, jumpY, 0.0f));
+    baseTransform = affineRotateZ(baseTransform, diveRotationZ);
     glm::vec3 torsoSize = g_keeperTorsoSize; glm::vec3 limbSize = g_keeperLimbSize; float headRadius = g_keeperHeadRadius;
     glm::vec3 neckSize(headRadius * 0.5f, 0.1f, headRadius * 0.5f);
     glm::vec3 handSize(limbSize.x * 1.3f, limbSize.x * 1.3f, limbSize.x * 1.3f);
     glm::vec3 footSize(limbSize.x * 1.1f, 0.15f, limbSize.z * 1.8f);
-    glBindVertexArray(cubeVAO);
-    drawCube(shaderProgram, glm::scale(baseTransform, torsoSize), color);
-    glm::mat4 neckModel_base = glm::translate(baseTransform, glm::vec3(0.0f, torsoSize.y / 2.0f, 0.0f));
-    glm::mat4 neckModel_final = glm::scale(glm::translate(neckModel_base, glm::vec3(0.0f, neckSize.y / 2.0f, 0.0f)), neckSize);
-    drawCube(shaderProgram, neckModel_final, g_skinColor);
-    glm::mat4 headModel = glm::scale(glm::translate(neckModel_base, glm::vec3(0.0f, neckSize.y + headRadius * 0.8f, 0.0f)), glm::vec3(headRadius));
-    drawSphere(shaderProgram, sphereVAO, sphereIndexCount, headModel, g_skinColor);
-    glBindVertexArray(cubeVAO);
+    drawCube(affineScale(baseTransform, torsoSize), color);
+    Affine3x4 neckModel_base = affineTranslate(baseTransform, glm::vec3(0.0f, torsoSize.y / 2.0f, 0.0f));
+    drawCube(affineScale(affineTranslate(neckModel_base, glm::vec3(0.0f, neckSize.y / 2.0f, 0.0f)), neckSize), g_skinColor);
+    Affine3x4 headModel = affineScale(affineTranslate(neckModel_base, glm::vec3(0.0f, neckSize.y + headRadius * 0.8f, 0.0f)), glm::vec3(headRadius));
+    drawSphere(headModel, g_skinColor);
     glm::vec3 legSize(0.2f, 0.4f, 0.2f);
-    glm::mat4 leftLegModel_base = glm::translate(baseTransform, glm::vec3(-0.15f, -torsoSize.y/2.0f - legSize.y/2.0f, 0.0f));
-    glm::mat4 leftLegModel_final = glm::scale(leftLegModel_base, legSize);
-    drawCube(shaderProgram, leftLegModel_final, g_team1Color1);
-    glm::mat4 peEsqModel_base = glm::translate(leftLegModel_base, glm::vec3(0.0f, -legSize.y/2.0f - footSize.y / 2.0f, 0.0f));
-    glm::mat4 peEsqModel_final = glm::scale(glm::translate(peEsqModel_base, glm::vec3(0.0f, 0.0f, footSize.z / 3.0f)), footSize);
-    drawCube(shaderProgram, peEsqModel_final, g_team1Color1); // Chuteira Preta
-    glm::mat4 rightLegModel_base = glm::translate(baseTransform, glm::vec3(0.15f, -torsoSize.y/2.0f - legSize.y/2.0f, 0.0f));
-    glm::mat4 rightLegModel_final = glm::scale(rightLegModel_base, legSize);
-    drawCube(shaderProgram, rightLegModel_final, g_team1Color1);
-    glm::mat4 peDirModel_base = glm::translate(rightLegModel_base, glm::vec3(0.0f, -legSize.y/2.0f - footSize.y / 2.0f, 0.0f));
-    glm::mat4 peDirModel_final = glm::scale(glm::translate(peDirModel_base, glm::vec3(0.0f, 0.0f, footSize.z / 3.0f)), footSize);
-    drawCube(shaderProgram, peDirModel_final, g_team1Color1); // Chuteira Preta
+    Affine3x4 leftLegModel_base = affineTranslate(baseTransform, glm::vec3(-0.15f, -torsoSize.y/2.0f - legSize.y/2.0f, 0.0f));
+    drawCube(affineScale(leftLegModel_base, legSize), g_team1Color1);
+    Affine3x4 peEsqModel_base = affineTranslate(leftLegModel_base, glm::vec3(0.0f, -legSize.y/2.0f - footSize.y / 2.0f, 0.0f));
+    drawCube(affineScale(affineTranslate(peEsqModel_base, glm::vec3(0.0f, 0.0f, footSize.z / 3.0f)), footSize), g_team1Color1); // Chuteira Preta
+    Affine3x4 rightLegModel_base = affineTranslate(baseTransform, glm::vec3(0.15f, -torsoSize.y/2.0f - legSize.y/2.0f, 0.0f));
+    drawCube(affineScale(rightLegModel_base, legSize), g_team1Color1);
+    Affine3x4 peDirModel_base = affineTranslate(rightLegModel_base, glm::vec3(0.0f, -legSize.y/2.0f - footSize.y / 2.0f, 0.0f));
+    drawCube(affineScale(affineTranslate(peDirModel_base, glm::vec3(0.0f, 0.0f, footSize.z / 3.0f)), footSize), g_team1Color1); // Chuteira Preta
     glm::vec3 shoulderL = glm::vec3(-torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f);
     glm::vec3 shoulderR = glm::vec3( torsoSize.x/2.0f, torsoSize.y * 0.4f, 0.0f);
-    glm::mat4 leftArmModel_base = glm::translate(baseTransform, shoulderL);
-    leftArmModel_base = glm::rotate(leftArmModel_base, armRotationX, glm::vec3(1.0f, 0.0f, 0.0f));
-    leftArmModel_base = glm::rotate(leftArmModel_base, armRotationY, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotação Y APLICADA
-    glm::mat4 leftArmModel_final = glm::translate(leftArmModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y / 2.0f, 0.0f));
-    leftArmModel_final = glm::scale(leftArmModel_final, limbSize);
-    drawCube(shaderProgram, leftArmModel_final, color);
-    glm::mat4 maoEsqModel_base = glm::translate(leftArmModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y, 0.0f));
-    glm::mat4 maoEsqModel_final = glm::scale(glm::translate(maoEsqModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize);
-    drawCube(shaderProgram, maoEsqModel_final, g_skinColor);
-    glm::mat4 rightArmModel_base = glm::translate(baseTransform, shoulderR);
-    rightArmModel_base = glm::rotate(rightArmModel_base, armRotationX, glm::vec3(1.0f, 0.0f, 0.0f));
-    rightArmModel_base = glm::rotate(rightArmModel_base, armRotationY, glm::vec3(0.0f, 1.0f, 0.0f)); // Rotação Y APLICADA
-    glm::mat4 rightArmModel_final = glm::translate(rightArmModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y / 2.0f, 0.0f));
-    rightArmModel_final = glm::scale(rightArmModel_final, limbSize);
-    drawCube(shaderProgram, rightArmModel_final, color);
-    glm::mat4 maoDirModel_base = glm::translate(rightArmModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y, 0.0f));
-    glm::mat4 maoDirModel_final = glm::scale(glm::translate(maoDirModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize);
-    drawCube(shaderProgram, maoDirModel_final, g_skinColor);
+    Affine3x4 leftArmModel_base = affineTranslate(baseTransform, shoulderL);
+    leftArmModel_base = affineRotateX(leftArmModel_base, armRotationX);
+    leftArmModel_base = affineRotateY(leftArmModel_base, armRotationY); // Rotação Y APLICADA
+    Affine3x4 leftArmModel_final = affineTranslate(leftArmModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y / 2.0f, 0.0f));
+    drawCube(affineScale(leftArmModel_final, limbSize), color);
+    Affine3x4 maoEsqModel_base = affineTranslate(leftArmModel_base, glm::vec3(-limbSize.x/2.0f, -limbSize.y, 0.0f));
+    drawCube(affineScale(affineTranslate(maoEsqModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize), g_skinColor);
+    Affine3x4 rightArmModel_base = affineTranslate(baseTransform, shoulderR);
+    rightArmModel_base = affineRotateX(rightArmModel_base, armRotationX);
+    rightArmModel_base = affineRotateY(rightArmModel_base, armRotationY); // Rotação Y APLICADA
+    Affine3x4 rightArmModel_final = affineTranslate(rightArmModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y / 2.0f, 0.0f));
+    drawCube(affineScale(rightArmModel_final, limbSize), color);
+    Affine3x4 maoDirModel_base = affineTranslate(rightArmModel_base, glm::vec3(limbSize.x/2.0f, -limbSize.y, 0.0f));
+    drawCube(affineScale(affineTranslate(maoDirModel_base, glm::vec3(0.0f, -handSize.y/2.0f, 0.0f)), handSize), g_skinColor);
 }
 
 // --- Funções de Cenário ---
-void drawField(unsigned int shaderProgram, unsigned int cubeVAO) {
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f)), glm::vec3(20.0f, 0.2f, 25.0f)), glm::vec4(0.0f, 0.5f, 0.1f, 1.0f));
+void drawField() {
+    g_drawMaterial = MAT_GRASS; g_drawOccluder = true;
+    drawCube(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f)), glm::vec3(20.0f, 0.2f, 25.0f)), glm::vec4(0.0f, 0.5f, 0.1f, 1.0f));
+    g_drawMaterial = MAT_NONE; g_drawOccluder = false;
 }
-void drawFieldMarkings(unsigned int shaderProgram, unsigned int cubeVAO) {
+// Marcações do campo em xz: (centro, meia largura). Também pintam a grama por cima delas (ver GRAMA).
+struct FieldMarking { glm::vec2 center, halfSize; };
+const FieldMarking g_fieldMarkings[8] = {
+    {{0.0f, -10.0f}, {10.0f, 0.05f}},  // Linha de fundo (gol)
+    {{0.0f, 12.5f}, {10.0f, 0.05f}},   // Linha de fundo (perto)
+    {{-10.0f, 0.0f}, {0.05f, 12.5f}},  // Laterais
+    {{10.0f, 0.0f}, {0.05f, 12.5f}},
+    {{0.0f, -6.0f}, {4.0f, 0.05f}},    // Grande área: frente e lados
+    {{-4.0f, -8.0f}, {0.05f, 2.0f}},
+    {{4.0f, -8.0f}, {0.05f, 2.0f}},
+    {{0.0f, 6.0f}, {0.1f, 0.1f}},      // Marca do pênalti
+};
+void drawFieldMarkings() {
     glm::vec4 white(1.0f, 1.0f, 1.0f, 1.0f);
-    float lineY = 0.01f; float lineWidth = 0.1f;
-    float fieldWidth = 20.0f; float fieldDepth = 25.0f; float halfWidth = fieldWidth / 2.0f; float halfDepth = fieldDepth / 2.0f;
-    float farGoalLineZ = -10.0f; float nearGoalLineZ = halfDepth;
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0, lineY, farGoalLineZ)), glm::vec3(fieldWidth, 0.01f, lineWidth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0, lineY, nearGoalLineZ)), glm::vec3(fieldWidth, 0.01f, lineWidth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-halfWidth, lineY, 0.0f)), glm::vec3(lineWidth, 0.01f, fieldDepth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(halfWidth, lineY, 0.0f)), glm::vec3(lineWidth, 0.01f, fieldDepth)), white);
-    float penaltyAreaWidth = 8.0f; float penaltyAreaDepth = 4.0f; float penaltySpotZ = 6.0f; // Posição corrigida
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0, lineY, farGoalLineZ + penaltyAreaDepth)), glm::vec3(penaltyAreaWidth, 0.01f, lineWidth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-penaltyAreaWidth/2.0f, lineY, farGoalLineZ + penaltyAreaDepth/2.0f)), glm::vec3(lineWidth, 0.01f, penaltyAreaDepth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(penaltyAreaWidth/2.0f, lineY, farGoalLineZ + penaltyAreaDepth/2.0f)), glm::vec3(lineWidth, 0.01f, penaltyAreaDepth)), white);
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0, lineY, penaltySpotZ)), glm::vec3(0.2f, 0.01f, 0.2f)), white);
-}
-void drawGoal(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int cylinderVAO, int cylinderIndexCount) {
+    float lineY = 0.01f;
+    for (const FieldMarking& m : g_fieldMarkings)
+        drawCube(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(m.center.x, lineY, m.center.y)), glm::vec3(m.halfSize.x * 2.0f, 0.01f, m.halfSize.y * 2.0f)), white);
+}
+void drawGoal() {
     glm::vec4 goalColor(0.9f, 0.9f, 0.9f, 1.0f);
     glm::vec4 netColor(0.9f, 0.9f, 0.9f, 0.4f);
     float goalLineZ = -10.0f;
@@ -523,89 +1737,56 @@ void drawGoal(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int cyl
     float animatedGoalBackNetZ = backNetZ + netBackZOffset;
 
     // --- Draw Goal Frame (Cylinders) ---
-    glm::mat4 leftPostModel = glm::translate(glm::mat4(1.0f), glm::vec3(-g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ));
-    drawCylinder(shaderProgram, cylinderVAO, cylinderIndexCount, leftPostModel, g_goalHeight, postRadius, goalColor);
-    glm::mat4 rightPostModel = glm::translate(glm::mat4(1.0f), glm::vec3(g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ));
-    drawCylinder(shaderProgram, cylinderVAO, cylinderIndexCount, rightPostModel, g_goalHeight, postRadius, goalColor);
-    glm::mat4 crossbarModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, g_goalHeight, goalLineZ));
-    crossbarModel = glm::rotate(crossbarModel, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    drawCylinder(shaderProgram, cylinderVAO, cylinderIndexCount, crossbarModel, g_goalWidth, postRadius, goalColor);
+    Affine3x4 leftPostModel = affineTranslation(glm::vec3(-g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ));
+    drawCylinder(leftPostModel, g_goalHeight, postRadius, goalColor);
+    Affine3x4 rightPostModel = affineTranslation(glm::vec3(g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ));
+    drawCylinder(rightPostModel, g_goalHeight, postRadius, goalColor);
+    Affine3x4 crossbarModel = affineTranslation(glm::vec3(0.0f, g_goalHeight, goalLineZ));
+    crossbarModel = affineRotateZ(crossbarModel, glm::radians(90.0f));
+    drawCylinder(crossbarModel, g_goalWidth, postRadius, goalColor);
 
     // --- Draw Back Support Structure (Cylinders) ---
-    glm::mat4 backLeftPostModel = glm::translate(glm::mat4(1.0f), glm::vec3(-g_goalWidth/2.0f, backPostHeight/2.0f, supportPostsZ));
-    drawCylinder(shaderProgram, cylinderVAO, cylinderIndexCount, backLeftPostModel, backPostHeight, postRadius * 0.8f, goalColor);
-    glm::mat4 backRightPostModel = glm::translate(glm::mat4(1.0f), glm::vec3(g_goalWidth/2.0f, backPostHeight/2.0f, supportPostsZ));
-    drawCylinder(shaderProgram, cylinderVAO, cylinderIndexCount, backRightPostModel, backPostHeight, postRadius * 0.8f, goalColor);
+    Affine3x4 backLeftPostModel = affineTranslation(glm::vec3(-g_goalWidth/2.0f, backPostHeight/2.0f, supportPostsZ));
+    drawCylinder(backLeftPostModel, backPostHeight, postRadius * 0.8f, goalColor);
+    Affine3x4 backRightPostModel = affineTranslation(glm::vec3(g_goalWidth/2.0f, backPostHeight/2.0f, supportPostsZ));
+    drawCylinder(backRightPostModel, backPostHeight, postRadius * 0.8f, goalColor);
 
 
     // --- Barras Diagonais Superiores 
+    // O cilindro é simétrico em Y: basta alinhar o eixo Y com a barra (sem acos/cross)
     float diagonalRadius = postRadius * 0.7f;
-    glm::vec3 yAxis(0.0f, 1.0f, 0.0f); // Default cylinder orientation
 
     // Barra Diagonal Esquerda
     glm::vec3 startLeft = glm::vec3(-g_goalWidth/2.0f, g_goalHeight, goalLineZ);
     glm::vec3 endLeft = glm::vec3(-g_goalWidth/2.0f, backPostHeight, supportPostsZ);
-    glm::vec3 centerLeft = (startLeft + endLeft) / 2.0f;
-    float lengthLeft = glm::distance(startLeft, endLeft);
-    glm::vec3 directionLeft = glm::normalize(endLeft - startLeft);
-
-    glm::vec3 axisLeft = glm::cross(yAxis, directionLeft);
-    float dotLeft = glm::dot(yAxis, directionLeft);
-
-    dotLeft = std::max(-1.0f, std::min(1.0f, dotLeft));
-    float angleLeft = glm::acos(dotLeft);
-
-    glm::mat4 rotationLeft = glm::rotate(glm::mat4(1.0f), angleLeft, axisLeft);
-    glm::mat4 scaleLeft = glm::scale(glm::mat4(1.0f), glm::vec3(diagonalRadius, lengthLeft, diagonalRadius)); // Scale applied last
-    glm::mat4 diagLeftModel = glm::translate(glm::mat4(1.0f), centerLeft) * rotationLeft * scaleLeft;
-
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(diagLeftModel));
-    glUniform4f(glGetUniformLocation(shaderProgram, "objectColor"), goalColor.r, goalColor.g, goalColor.b, goalColor.a);
-    glBindVertexArray(cylinderVAO);
-    glDrawElements(GL_TRIANGLES, cylinderIndexCount, GL_UNSIGNED_INT, 0);
-
+    Affine3x4 diagLeftModel = affineAlignY((startLeft + endLeft) / 2.0f, endLeft - startLeft);
+    drawCylinder(diagLeftModel, glm::distance(startLeft, endLeft), diagonalRadius, goalColor);
 
     // Barra Diagonal Direita
     glm::vec3 startRight = glm::vec3(g_goalWidth/2.0f, g_goalHeight, goalLineZ);
     glm::vec3 endRight = glm::vec3(g_goalWidth/2.0f, backPostHeight, supportPostsZ);
-    glm::vec3 centerRight = (startRight + endRight) / 2.0f;
-    float lengthRight = glm::distance(startRight, endRight);
-    glm::vec3 directionRight = glm::normalize(endRight - startRight);
-
-    glm::vec3 axisRight = glm::cross(yAxis, directionRight);
-    float dotRight = glm::dot(yAxis, directionRight);
-    dotRight = std::max(-1.0f, std::min(1.0f, dotRight));
-    float angleRight = glm::acos(dotRight);
-
-    glm::mat4 rotationRight = glm::rotate(glm::mat4(1.0f), angleRight, axisRight);
-    glm::mat4 scaleRight = glm::scale(glm::mat4(1.0f), glm::vec3(diagonalRadius, lengthRight, diagonalRadius));
-    glm::mat4 diagRightModel = glm::translate(glm::mat4(1.0f), centerRight) * rotationRight * scaleRight;
-
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(diagRightModel));
-    // Color already set
-    glDrawElements(GL_TRIANGLES, cylinderIndexCount, GL_UNSIGNED_INT, 0);
+    Affine3x4 diagRightModel = affineAlignY((startRight + endRight) / 2.0f, endRight - startRight);
+    drawCylinder(diagRightModel, glm::distance(startRight, endRight), diagonalRadius, goalColor);
     // --- FIM Barras Diagonais ---
 
 
     // --- Draw Net 
-    glBindVertexArray(cubeVAO);
     float netThickness = 0.02f;
     // Back Net
-    drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, g_goalHeight/2.0f, animatedGoalBackNetZ)), glm::vec3(g_goalWidth, g_goalHeight, netThickness)), netColor);
+    drawCube(affineScale(affineTranslation(glm::vec3(0.0f, g_goalHeight/2.0f, animatedGoalBackNetZ)), glm::vec3(g_goalWidth, g_goalHeight, netThickness)), netColor);
     // Left Side Net
-    glm::mat4 leftSideNetModel = glm::translate(glm::mat4(1.0f), glm::vec3(-g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ - netDepth/2.0f));
-    leftSideNetModel = glm::rotate(leftSideNetModel, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    drawCube(shaderProgram, glm::scale(leftSideNetModel, glm::vec3(netDepth, g_goalHeight, netThickness)), netColor);
+    Affine3x4 leftSideNetModel = affineTranslation(glm::vec3(-g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ - netDepth/2.0f));
+    leftSideNetModel = affineRotateY(leftSideNetModel, glm::radians(90.0f));
+    drawCube(affineScale(leftSideNetModel, glm::vec3(netDepth, g_goalHeight, netThickness)), netColor);
     // Right Side Net
-    glm::mat4 rightSideNetModel = glm::translate(glm::mat4(1.0f), glm::vec3(g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ - netDepth/2.0f));
-    rightSideNetModel = glm::rotate(rightSideNetModel, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    drawCube(shaderProgram, glm::scale(rightSideNetModel, glm::vec3(netDepth, g_goalHeight, netThickness)), netColor);
+    Affine3x4 rightSideNetModel = affineTranslation(glm::vec3(g_goalWidth/2.0f, g_goalHeight/2.0f, goalLineZ - netDepth/2.0f));
+    rightSideNetModel = affineRotateY(rightSideNetModel, glm::radians(90.0f));
+    drawCube(affineScale(rightSideNetModel, glm::vec3(netDepth, g_goalHeight, netThickness)), netColor);
     // Top Net
-    glm::mat4 topNetModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, g_goalHeight, goalLineZ - netDepth/2.0f));
-    topNetModel = glm::rotate(topNetModel, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    drawCube(shaderProgram, glm::scale(topNetModel, glm::vec3(g_goalWidth, netDepth, netThickness)), netColor);
+    Affine3x4 topNetModel = affineTranslation(glm::vec3(0.0f, g_goalHeight, goalLineZ - netDepth/2.0f));
+    topNetModel = affineRotateX(topNetModel, glm::radians(90.0f));
+    drawCube(affineScale(topNetModel, glm::vec3(g_goalWidth, netDepth, netThickness)), netColor);
 
-    glBindVertexArray(0); 
 }
 
 // void drawCrowd(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sphereVAO, int sphereIndexCount) {
@@ -663,10 +1844,8 @@ void drawGoal(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int cyl
 // }
 
 
-void drawCrowd(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sphereVAO, int sphereIndexCount) {
+void drawCrowd() {
     
-    // Salva o estado ATUAL do jogo
-    GameState realGameState = g_gameState;
     // Pega o time que chutou (se for gol, é o time que comemora)
     Team teamThatScored = g_currentKicker; 
 
@@ -678,7 +1857,25 @@ void drawCrowd(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sp
     float fieldLength = 25.0f;  // Comprimento total do campo
     
     float spacingZ = 2.0f; // Espaço entre cada torcedor no eixo Z
+
+    // g_crowdScale > 1: metade do fator vira fileiras extras (continuando os degraus) e metade vira densidade
+    int rowMultiplier = (int)std::ceil(std::sqrt((float)g_crowdScale));
+    spacingZ /= (float)g_crowdScale / rowMultiplier;
+    numSteps *= rowMultiplier;
     int spectatorsPerRow = (int)(fieldLength / spacingZ);
+    int spectatorsPerSide = numSteps * spectatorsPerRow;
+
+    // Lógica de Animação: a torcida do time que marcou comemora durante o GOL; o resto fica parado.
+    // Cada lado da arquibancada é de um time, então basta um rig por lado, montado uma única vez.
+    PlayerRig rigs[2];
+    for (int side = 0; side < 2; ++side) {
+        Team team = (side == 0) ? TEAM_1 : TEAM_2;
+        GameState animation = (g_gameState == STATE_GOAL && teamThatScored == team) ? STATE_CELEBRATING : STATE_READY;
+        buildPlayerRig(animation, g_animationTimer, team, rigs[side]);
+    }
+
+    // Bases de cada torcedor (na arena, sem alocar no heap): lado 0 = esquerda (Time 1), lado 1 = direita (Time 2)
+    FrameVector<Affine3x4> bases(spectatorsPerSide * 2);
 
     // Loop pelas fileiras (degraus)
     for (int i = 0; i < numSteps; ++i) {
@@ -689,41 +1886,26 @@ void drawCrowd(unsigned int shaderProgram, unsigned int cubeVAO, unsigned int sp
 
         // Loop pelos "assentos" (ao longo do eixo Z)
         for (int j = 0; j < spectatorsPerRow; ++j) {
-            
             float zPos = -(fieldLength / 2.0f) + (spacingZ / 2.0f) + (j * spacingZ);
-            
-            // --- Desenha Torcedor da Esquerda (Time 1 - Preto) ---
-            
-            // Lógica de Animação:
-            // Se o estado real é GOAL e o Time 1 marcou
-            if (realGameState == STATE_GOAL && teamThatScored == TEAM_1) {
-                g_gameState = STATE_CELEBRATING; // Ativa a comemoração
-            } else {
-                g_gameState = STATE_READY; // Senão, fique parado
-            }
-            glm::vec3 posLeft(xPosLeft, yPos, zPos);
-            drawPlayer(shaderProgram, cubeVAO, sphereVAO, sphereIndexCount, posLeft, TEAM_1);
-            
-            // --- Desenha Torcedor da Direita (Time 2 - Azul) ---
-            
-            // Lógica de Animação:
-            // Se o estado real é GOAL e o Time 2 marcou
-            if (realGameState == STATE_GOAL && teamThatScored == TEAM_2) {
-                g_gameState = STATE_CELEBRATING; // Ativa a comemoração
-            } else {
-                g_gameState = STATE_READY; // Senão, fique parado
-            }
-            glm::vec3 posRight(xPosRight, yPos, zPos);
-            drawPlayer(shaderProgram, cubeVAO, sphereVAO, sphereIndexCount, posRight, TEAM_2);
+            bases[i * spectatorsPerRow + j] = playerBaseTransform(glm::vec3(xPosLeft, yPos, zPos));
+            bases[spectatorsPerSide + i * spectatorsPerRow + j] = playerBaseTransform(glm::vec3(xPosRight, yPos, zPos));
+        }
+    }
+
+    // Compõe todas as partes de todos os torcedores de um lado de uma vez e desenha
+    for (int side = 0; side < 2; ++side) {
+        const PlayerRig& rig = rigs[side];
+        FrameVector<Affine3x4> world((size_t)spectatorsPerSide * rig.count);
+        affineComposeRigs(bases.data() + side * spectatorsPerSide, spectatorsPerSide, rig.transforms, rig.count, world.data());
+        for (int s = 0; s < spectatorsPerSide; ++s) {
+            drawRigParts(rig, world.data() + (size_t)s * rig.count);
         }
     }
-    
-    // Restaura o estado real do jogo
-    g_gameState = realGameState;
 }
 
-void drawGrandstands(unsigned int shaderProgram, unsigned int cubeVAO) {
+void drawGrandstands() {
     glm::vec4 concreteColor(0.5f, 0.5f, 0.5f, 1.0f); // Cor de concreto
+    g_drawMaterial = MAT_CONCRETE; g_drawOccluder = true;
     
     int numSteps = 4;           // Número de "degraus" da arquibancada
     float stepWidth = 1.0f;     // Largura (em X) de cada degrau
@@ -750,7 +1932,7 @@ void drawGrandstands(unsigned int shaderProgram, unsigned int cubeVAO) {
         
         glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(xPos, yPos, 0.0f));
         model = glm::scale(model, lateralStepSize);
-        drawCube(shaderProgram, model, concreteColor);
+        drawCube(model, concreteColor);
     }
 
     // Arquibancada Direita (X positivo)
@@ -760,7 +1942,7 @@ void drawGrandstands(unsigned int shaderProgram, unsigned int cubeVAO) {
         
         glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(xPos, yPos, 0.0f));
         model = glm::scale(model, lateralStepSize);
-        drawCube(shaderProgram, model, concreteColor);
+        drawCube(model, concreteColor);
     }
 
     // O comprimento (em X) da arquibancada traseira deve cobrir a largura do campo + as laterais da arquibancada
@@ -777,11 +1959,12 @@ void drawGrandstands(unsigned int shaderProgram, unsigned int cubeVAO) {
         
         glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(xPos, yPos, zPos));
         model = glm::scale(model, backStepSize);
-        drawCube(shaderProgram, model, concreteColor);
+        drawCube(model, concreteColor);
     }
+    g_drawMaterial = MAT_NONE; g_drawOccluder = false;
 }
 
-void drawScoreboard(unsigned int shaderProgram, unsigned int cubeVAO) {
+void drawScoreboard() {
     glm::vec3 scorePos(3.5f, 3.5f, -10.0f);
     float cubeSize = 0.4f; float spacing = 0.5f;
     glm::vec4 gray(0.3f, 0.3f, 0.3f, 1.0f);
@@ -789,12 +1972,918 @@ void drawScoreboard(unsigned int shaderProgram, unsigned int cubeVAO) {
     glm::vec4 red(0.8f, 0.1f, 0.1f, 1.0f);
     for (int i = 0; i < 3; ++i) {
         glm::vec4 color = gray; if (g_team1Results[i] == 1) color = green; if (g_team1Results[i] == 2) color = red;
-        drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), scorePos + glm::vec3(i * spacing, 0.0f, 0.0f)), glm::vec3(cubeSize)), color);
+        drawCube(glm::scale(glm::translate(glm::mat4(1.0f), scorePos + glm::vec3(i * spacing, 0.0f, 0.0f)), glm::vec3(cubeSize)), color);
     }
     for (int i = 0; i < 3; ++i) {
         glm::vec4 color = gray; if (g_team2Results[i] == 1) color = green; if (g_team2Results[i] == 2) color = red;
-        drawCube(shaderProgram, glm::scale(glm::translate(glm::mat4(1.0f), scorePos + glm::vec3(i * spacing, -spacing, 0.0f)), glm::vec3(cubeSize)), color);
+        drawCube(glm::scale(glm::translate(glm::mat4(1.0f), scorePos + glm::vec3(i * spacing, -spacing, 0.0f)), glm::vec3(cubeSize)), color);
+    }
+}
+
+
+// --- LOG DE EVENTOS ---
+// O código do jogo só empilha eventos tipados numa fila sem lock; uma thread de fundo
+// escreve a saída legível no console e a telemetria em JSONL, fora do loop de frame.
+
+// Fila limitada multi-produtor / consumidor único (sequência por célula, sem locks).
+// Capacity precisa ser potência de 2.
+template <typename T, size_t Capacity>
+struct MpscQueue {
+    struct Cell { std::atomic<size_t> sequence; T data; };
+    Cell cells[Capacity];
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+    MpscQueue() : head(0), tail(0) {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity deve ser potencia de 2");
+        for (size_t i = 0; i < Capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Retorna false se a fila estiver cheia (o evento é descartado, nunca bloqueia o frame)
+    bool push(const T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& out) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & (Capacity - 1)];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) return false;
+        out = cell.data;
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+enum EventType { EVT_KICK_PROMPT, EVT_RUN_UP, EVT_KICK, EVT_KEEPER_CHOICE, EVT_SAVE, EVT_GOAL, EVT_MISS, EVT_STATE_CHANGE, EVT_FINAL_SCORE, EVT_SETTING };
+enum SettingId { SETTING_TRANSPARENCY, SETTING_LOW_LATENCY }; // EVT_SETTING: value = ajuste, value2 = novo valor (teclas de debug)
+
+struct GameEvent {
+    EventType type;
+    double time;      // glfwGetTime() no momento do evento
+    float matchTime;  // Tempo de simulação da partida (determinístico no --bench)
+    Team team;        // Time que está batendo
+    int kick;         // Índice da cobrança (0..5)
+    int value;        // Escolha do chute/goleiro, estado anterior ou placar do Time 1
+    int value2;       // Novo estado ou placar do Time 2
+};
+
+struct EventLog {
+    MpscQueue<GameEvent, 1024> queue;
+    std::atomic<bool> running{false};
+    std::atomic<unsigned int> dropped{0};
+    std::thread worker;
+    std::ofstream jsonl;
+};
+EventLog g_eventLog;
+std::string g_eventLogPath; // --event-log arquivo.jsonl; vazio (padrão) desativa a telemetria em JSONL
+
+const char* gameStateName(int state) {
+    static const char* names[] = {"ready", "running_up", "kicking", "ball_in_flight", "saved", "goal", "resetting", "gameover", "celebrating"};
+    return (state >= 0 && state <= STATE_CELEBRATING) ? names[state] : "unknown";
+}
+
+void logEvent(EventType type, int value = 0, int value2 = 0) {
+    GameEvent event;
+    event.type = type; event.time = glfwGetTime(); event.matchTime = g_matchTime;
+    event.team = g_currentKicker; event.kick = g_currentKick;
+    event.value = value; event.value2 = value2;
+    if (!g_eventLog.queue.push(event)) g_eventLog.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Toda troca de estado da máquina do jogo passa por aqui para ficar registrada no log
+void setGameState(GameState state) {
+    if (state == g_gameState) return;
+    logEvent(EVT_STATE_CHANGE, g_gameState, state);
+    g_gameState = state;
+}
+
+void writeEventConsole(const GameEvent& e) {
+    switch (e.type) {
+    case EVT_KICK_PROMPT:
+        std::cout << "\n--- Vez do Time " << (e.team == TEAM_1 ? "1 (Listrado)" : "2 (Azul)") << " ---\n";
+        std::cout << "Chute " << (e.kick / 2) + 1 << " de 3.\n\n";
+        std::cout << "Escolha onde chutar:\n" << "1) Meio\n" << "2) Direita (Canto)\n" << "3) Esquerda (Canto)\n"
+                  << "--------------------------------\n";
+        break;
+    case EVT_RUN_UP: std::cout << "Jogador correndo...\n"; break;
+    case EVT_KICK:   std::cout << "CHUTOU!\n"; break;
+    case EVT_SAVE:   std::cout << "DEFENDEU!!!\n"; break;
+    case EVT_GOAL:   std::cout << "GOOOOOOL! Bola entrou no gol (registrado).\n"; break;
+    case EVT_MISS:   std::cout << "Fora do gol.\n"; break;
+    case EVT_FINAL_SCORE:
+        std::cout << "\n\n======= FIM DE JOGO! =======\n";
+        std::cout << "  Placar Final: \n" << "  Time 1 (Listrado): " << e.value << "\n" << "  Time 2 (Azul):     " << e.value2 << "\n";
+        if (e.value > e.value2) std::cout << "  Time 1 VENCEU!\n";
+        else if (e.value2 > e.value) std::cout << "  Time 2 VENCEU!\n";
+        else std::cout << "  EMPATE!\n";
+        std::cout << "===========================\n";
+        break;
+    case EVT_SETTING:
+        if (e.value == SETTING_TRANSPARENCY) std::cout << "Transparencia: " << (e.value2 == TRANSPARENCY_OIT ? "OIT" : "ordenada") << "\n";
+        if (e.value == SETTING_LOW_LATENCY) std::cout << "Modo de baixa latencia: " << (e.value2 ? "ligado" : "desligado") << "\n";
+        break;
+    default: break; // Escolha do goleiro e trocas de estado só vão para o JSONL
+    }
+}
+
+void writeEventJson(std::ostream& out, const GameEvent& e) {
+    static const char* names[] = {"kick_prompt", "run_up", "kick", "keeper_choice", "save", "goal", "miss", "state_change", "final_score", "setting"};
+    static const char* settings[] = {"transparency", "low_latency"};
+    out << "{\"t\": " << e.time << ", \"match_t\": " << e.matchTime << ", \"event\": \"" << names[e.type]
+        << "\", \"team\": " << (e.team == TEAM_1 ? 1 : 2) << ", \"kick\": " << e.kick;
+    switch (e.type) {
+    case EVT_KICK:          out << ", \"choice\": " << e.value; break;
+    case EVT_KEEPER_CHOICE: out << ", \"choice\": " << e.value; break;
+    case EVT_STATE_CHANGE:  out << ", \"from\": \"" << gameStateName(e.value) << "\", \"to\": \"" << gameStateName(e.value2) << "\""; break;
+    case EVT_FINAL_SCORE:   out << ", \"score1\": " << e.value << ", \"score2\": " << e.value2; break;
+    case EVT_SETTING:       out << ", \"setting\": \"" << settings[e.value] << "\", \"value\": " << e.value2; break;
+    default: break;
+    }
+    out << "}\n";
+}
+
+void eventLogThread() {
+    GameEvent event;
+    for (;;) {
+        bool wrote = false;
+        while (g_eventLog.queue.pop(event)) {
+            writeEventConsole(event);
+            if (g_eventLog.jsonl) writeEventJson(g_eventLog.jsonl, event);
+            wrote = true;
+        }
+        if (wrote) { std::cout.flush(); if (g_eventLog.jsonl) g_eventLog.jsonl.flush(); }
+        else if (!g_eventLog.running.load(std::memory_order_acquire)) break; // Fila vazia e pedido de parada
+        else std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void startEventLog() {
+    if (!g_eventLogPath.empty()) {
+        g_eventLog.jsonl.open(g_eventLogPath);
+        g_eventLog.jsonl << std::fixed << std::setprecision(4);
+    }
+    g_eventLog.running = true;
+    g_eventLog.worker = std::thread(eventLogThread);
+}
+
+// Esvazia a fila antes de encerrar para não perder o placar final
+void stopEventLog() {
+    if (!g_eventLog.worker.joinable()) return;
+    g_eventLog.running.store(false, std::memory_order_release);
+    g_eventLog.worker.join();
+    if (g_eventLog.dropped > 0) std::cout << "Log de eventos: " << g_eventLog.dropped << " eventos descartados (fila cheia)" << std::endl;
+}
+
+
+// --- ÁUDIO ---
+// Mixer numa thread própria: o jogo só empilha comandos (tocar som, ouvinte, intensidade da torcida) numa
+// MpscQueue e nunca espera por ele. Os sons são sintetizados na inicialização (mono, 48 kHz). Cada buffer soma
+// até AUDIO_MAX_VOICES vozes com atenuação por distância e pan a partir da câmera orbital, mais a torcida em loop.
+// Saídas: nula (descarta no ritmo do tempo real) ou arquivo WAV (--audio-wav); não há backend de placa de som.
+const int AUDIO_RATE = 48000;
+const int AUDIO_BUFFER_FRAMES = 512; // ~10,7 ms por buffer
+const int AUDIO_MAX_VOICES = 64;     // A voz 0 é sempre a torcida
+const float AUDIO_REF_DISTANCE = 6.0f; // Até essa distância o som não atenua; depois cai com 1/d
+
+enum SoundId { SOUND_KICK, SOUND_SAVE, SOUND_POST, SOUND_NET, SOUND_GOAL_ROAR, SOUND_CROWD_BED, SOUND_COUNT };
+enum AudioCommandType { AUDIO_PLAY, AUDIO_LISTENER, AUDIO_CROWD };
+enum AudioOutput { AUDIO_OUTPUT_OFF, AUDIO_OUTPUT_NULL, AUDIO_OUTPUT_WAV };
+
+struct AudioCommand {
+    AudioCommandType type;
+    SoundId sound;
+    glm::vec3 position; // Fonte (PLAY) ou ouvinte (LISTENER)
+    glm::vec3 right;    // Eixo direito do ouvinte (LISTENER)
+    float gain;         // Volume (PLAY) ou intensidade da torcida (CROWD)
+    bool spatial;       // false: sem atenuação nem pan (o estádio inteiro)
+};
+
+struct AudioVoice {
+    const float* samples = nullptr; // nullptr = voz livre
+    int length = 0, position = 0;
+    bool loop = false, spatial = true;
+    glm::vec3 source = glm::vec3(0.0f);
+    float gain = 0.0f;
+    float gainL = 0.0f, gainR = 0.0f; // Ganhos aplicados no fim do último buffer: a rampa do próximo parte deles
+};
+
+struct AudioMixer {
+    std::vector<float> sounds[SOUND_COUNT];
+    AudioVoice voices[AUDIO_MAX_VOICES];
+    float crowdTarget = 0.25f;
+    glm::vec3 listener = glm::vec3(0.0f, 1.0f, 20.0f), listenerRight = glm::vec3(1.0f, 0.0f, 0.0f);
+    alignas(16) float mixL[AUDIO_BUFFER_FRAMES];
+    alignas(16) float mixR[AUDIO_BUFFER_FRAMES];
+    int16_t output[AUDIO_BUFFER_FRAMES * 2];
+    MpscQueue<AudioCommand, 256> commands;
+
+    AudioOutput outputMode = AUDIO_OUTPUT_NULL; // --no-audio / --audio-wav
+    std::string wavPath;
+    std::ofstream wav;
+    uint32_t wavFrames = 0;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<unsigned int> dropped{0};
+
+    // Custo da mixagem (gravado pelo mixer; o HUD lê só mixUs)
+    std::atomic<float> mixUs{0.0f};
+    double mixUsSum = 0.0, mixUsMax = 0.0;
+    unsigned long long buffers = 0;
+    int peakVoices = 0, stolenVoices = 0;
+};
+AudioMixer g_audio;
+
+// Ruído determinístico para a síntese (não mexe no g_randomEngine do jogo)
+float audioNoise(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+void normalizeSound(std::vector<float>& samples, float peak) {
+    float maxAbs = 0.0f;
+    for (float s : samples) maxAbs = std::max(maxAbs, std::abs(s));
+    if (maxAbs > 0.0f) for (float& s : samples) s *= peak / maxAbs;
+}
+
+void synthesizeSounds(AudioMixer& a) {
+    uint32_t seed = 12345;
+    auto make = [&](SoundId id, float seconds) -> std::vector<float>& {
+        a.sounds[id].assign((size_t)(seconds * AUDIO_RATE), 0.0f);
+        return a.sounds[id];
+    };
+    auto time = [](size_t i) { return i / (float)AUDIO_RATE; };
+
+    // Chute: baque grave descendo de tom com o estalo do contato
+    std::vector<float>& kick = make(SOUND_KICK, 0.25f);
+    for (size_t i = 0; i < kick.size(); ++i) {
+        float t = time(i);
+        kick[i] = std::sin(2.0f * PI * (95.0f - 120.0f * t) * t) * std::exp(-t * 22.0f) + 0.5f * audioNoise(seed) * std::exp(-t * 250.0f);
+    }
+    normalizeSound(kick, 0.9f);
+
+    // Defesa: luva abafando a bola (ruído passa-baixa + baque)
+    std::vector<float>& save = make(SOUND_SAVE, 0.3f);
+    float low = 0.0f;
+    for (size_t i = 0; i < save.size(); ++i) {
+        float t = time(i);
+        low += 0.08f * (audioNoise(seed) - low);
+        save[i] = (3.0f * low + 0.6f * std::sin(2.0f * PI * 70.0f * t)) * std::exp(-t * 18.0f);
+    }
+    normalizeSound(save, 0.8f);
+
+    // Trave: parciais inarmônicas de metal, cada uma decaindo no seu ritmo
+    std::vector<float>& post = make(SOUND_POST, 1.2f);
+    const float partials[4][2] = {{523.0f, 3.0f}, {1318.0f, 4.5f}, {2351.0f, 7.0f}, {3702.0f, 11.0f}};
+    for (size_t i = 0; i < post.size(); ++i) {
+        float t = time(i);
+        for (const auto& p : partials) post[i] += std::sin(2.0f * PI * p[0] * t) * std::exp(-t * p[1]);
+    }
+    normalizeSound(post, 0.7f);
+
+    // Rede: chiado que sobe rápido e morre
+    std::vector<float>& net = make(SOUND_NET, 0.5f);
+    low = 0.0f;
+    for (size_t i = 0; i < net.size(); ++i) {
+        float t = time(i);
+        low += 0.3f * (audioNoise(seed) - low);
+        net[i] = low * std::min(1.0f, t / 0.03f) * std::exp(-t * 9.0f);
+    }
+    normalizeSound(net, 0.6f);
+
+    // Rugido do gol: ruído grave que cresce, sustenta e cai, com ondulação de vozes
+    std::vector<float>& roar = make(SOUND_GOAL_ROAR, 3.5f);
+    float low1 = 0.0f, low2 = 0.0f;
+    for (size_t i = 0; i < roar.size(); ++i) {
+        float t = time(i);
+        low1 += 0.12f * (audioNoise(seed) - low1);
+        low2 += 0.12f * (low1 - low2);
+        float envelope = std::min(1.0f, t / 0.4f) * (t > 2.0f ? std::exp(-(t - 2.0f) * 2.0f) : 1.0f);
+        roar[i] = low2 * envelope * (0.8f + 0.2f * std::sin(2.0f * PI * 3.1f * t));
+    }
+    normalizeSound(roar, 0.9f);
+
+    // Torcida de fundo: murmúrio em loop; o fim é misturado com o começo para o loop não estalar
+    const size_t bedLength = (size_t)(4.0f * AUDIO_RATE), fade = AUDIO_RATE / 4;
+    std::vector<float>& bed = make(SOUND_CROWD_BED, 4.25f);
+    low1 = 0.0f; low2 = 0.0f;
+    for (size_t i = 0; i < bed.size(); ++i) {
+        float t = time(i);
+        low1 += 0.2f * (audioNoise(seed) - low1);
+        low2 += 0.2f * (low1 - low2);
+        bed[i] = low2 * (0.75f + 0.15f * std::sin(2.0f * PI * 0.5f * t) + 0.1f * std::sin(2.0f * PI * 1.7f * t));
+    }
+    for (size_t i = 0; i < fade; ++i) {
+        float w = i / (float)fade;
+        bed[i] = bed[i] * w + bed[bedLength + i] * (1.0f - w);
+    }
+    bed.resize(bedLength);
+    normalizeSound(bed, 0.5f);
+
+    AudioVoice& crowd = a.voices[0];
+    crowd.samples = bed.data(); crowd.length = (int)bed.size(); crowd.position = 0;
+    crowd.loop = true; crowd.spatial = false; crowd.gain = a.crowdTarget;
+}
+
+// Chamado pela simulação: nunca bloqueia (fila cheia descarta o som)
+void playSound(SoundId sound, glm::vec3 position, float gain = 1.0f, bool spatial = true) {
+    if (g_audio.outputMode == AUDIO_OUTPUT_OFF) return;
+    AudioCommand command;
+    command.type = AUDIO_PLAY; command.sound = sound; command.position = position; command.gain = gain; command.spatial = spatial;
+    if (!g_audio.commands.push(command)) g_audio.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void setAudioListener(glm::vec3 position, glm::vec3 target) {
+    if (g_audio.outputMode == AUDIO_OUTPUT_OFF) return;
+    AudioCommand command;
+    command.type = AUDIO_LISTENER; command.position = position;
+    command.right = glm::normalize(glm::cross(target - position, glm::vec3(0.0f, 1.0f, 0.0f)));
+    g_audio.commands.push(command); // Se a fila encher, o próximo frame manda outro
+}
+
+// Intensidade da torcida em cada estado do jogo
+float crowdIntensity(GameState state) {
+    switch (state) {
+    case STATE_RUNNING_UP:     return 0.4f;
+    case STATE_KICKING:
+    case STATE_BALL_IN_FLIGHT: return 0.55f;
+    case STATE_SAVED:          return 0.7f;
+    case STATE_GOAL:
+    case STATE_CELEBRATING:    return 1.0f;
+    case STATE_GAMEOVER:       return 0.8f;
+    default:                   return 0.25f;
+    }
+}
+
+// Ao fim de cada passo da simulação: avisa o mixer quando o estado do jogo muda
+void followCrowdAudio() {
+    static thread_local int lastState = -1;
+    if (g_audio.outputMode == AUDIO_OUTPUT_OFF || g_gameState == lastState) return;
+    AudioCommand command;
+    command.type = AUDIO_CROWD; command.gain = crowdIntensity(g_gameState);
+    if (g_audio.commands.push(command)) lastState = g_gameState;
+}
+
+// Soma samples * ganho (rampa linear por quadro) nos dois canais; 4 quadros por iteração com SSE
+void mixSegment(const float* samples, int count, float gainL, float stepL, float gainR, float stepR, float* outL, float* outR) {
+    int i = 0;
+#ifdef MIXER_SSE
+    const __m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 gl = _mm_add_ps(_mm_set1_ps(gainL), _mm_mul_ps(_mm_set1_ps(stepL), ramp));
+    __m128 gr = _mm_add_ps(_mm_set1_ps(gainR), _mm_mul_ps(_mm_set1_ps(stepR), ramp));
+    const __m128 dl = _mm_set1_ps(stepL * 4.0f), dr = _mm_set1_ps(stepR * 4.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 s = _mm_loadu_ps(samples + i);
+        _mm_storeu_ps(outL + i, _mm_add_ps(_mm_loadu_ps(outL + i), _mm_mul_ps(s, gl)));
+        _mm_storeu_ps(outR + i, _mm_add_ps(_mm_loadu_ps(outR + i), _mm_mul_ps(s, gr)));
+        gl = _mm_add_ps(gl, dl); gr = _mm_add_ps(gr, dr);
+    }
+#endif
+    for (; i < count; ++i) {
+        outL[i] += samples[i] * (gainL + stepL * i);
+        outR[i] += samples[i] * (gainR + stepR * i);
+    }
+}
+
+// Ganhos esquerdo/direito: 1/d depois da distância de referência e pan de potência constante
+void voiceGains(const AudioMixer& a, const AudioVoice& v, float& left, float& right) {
+    if (!v.spatial) { left = right = v.gain * 0.7071f; return; }
+    glm::vec3 toSource = v.source - a.listener;
+    float distance = glm::length(toSource);
+    float attenuation = AUDIO_REF_DISTANCE / std::max(AUDIO_REF_DISTANCE, distance);
+    float pan = distance > 0.001f ? glm::clamp(glm::dot(toSource / distance, a.listenerRight), -1.0f, 1.0f) : 0.0f;
+    float angle = (pan + 1.0f) * (PI / 4.0f);
+    left = v.gain * attenuation * std::cos(angle);
+    right = v.gain * attenuation * std::sin(angle);
+}
+
+// Voz livre; sem nenhuma, rouba o som (fora a torcida) mais perto de acabar
+int allocateVoice(AudioMixer& a) {
+    int best = -1; float bestProgress = -1.0f;
+    for (int i = 1; i < AUDIO_MAX_VOICES; ++i) {
+        const AudioVoice& v = a.voices[i];
+        if (!v.samples) return i;
+        float progress = v.position / (float)v.length;
+        if (!v.loop && progress > bestProgress) { best = i; bestProgress = progress; }
+    }
+    if (best >= 0) a.stolenVoices++;
+    return best;
+}
+
+void applyAudioCommands(AudioMixer& a) {
+    AudioCommand command;
+    while (a.commands.pop(command)) {
+        switch (command.type) {
+        case AUDIO_PLAY: {
+            int index = allocateVoice(a);
+            if (index < 0) break;
+            AudioVoice& v = a.voices[index];
+            v.samples = a.sounds[command.sound].data(); v.length = (int)a.sounds[command.sound].size(); v.position = 0;
+            v.loop = false; v.spatial = command.spatial; v.source = command.position; v.gain = command.gain;
+            voiceGains(a, v, v.gainL, v.gainR); // Começa já no ganho certo: a rampa só suaviza mudanças
+            break;
+        }
+        case AUDIO_LISTENER: a.listener = command.position; a.listenerRight = command.right; break;
+        case AUDIO_CROWD:    a.crowdTarget = command.gain; break;
+        }
+    }
+}
+
+// Um buffer completo: comandos pendentes, todas as vozes e a conversão para 16 bits
+void mixAudioBuffer(AudioMixer& a) {
+    applyAudioCommands(a);
+    AudioVoice& crowd = a.voices[0];
+    crowd.gain += (a.crowdTarget - crowd.gain) * 0.05f; // ~0,2 s para a torcida acompanhar o lance
+
+    std::fill(a.mixL, a.mixL + AUDIO_BUFFER_FRAMES, 0.0f);
+    std::fill(a.mixR, a.mixR + AUDIO_BUFFER_FRAMES, 0.0f);
+    int active = 0;
+    for (AudioVoice& v : a.voices) {
+        if (!v.samples) continue;
+        active++;
+        float targetL, targetR;
+        voiceGains(a, v, targetL, targetR);
+        float stepL = (targetL - v.gainL) / AUDIO_BUFFER_FRAMES, stepR = (targetR - v.gainR) / AUDIO_BUFFER_FRAMES;
+        int done = 0;
+        while (done < AUDIO_BUFFER_FRAMES && v.samples) {
+            int count = std::min(AUDIO_BUFFER_FRAMES - done, v.length - v.position);
+            mixSegment(v.samples + v.position, count, v.gainL + stepL * done, stepL, v.gainR + stepR * done, stepR, a.mixL + done, a.mixR + done);
+            done += count; v.position += count;
+            if (v.position == v.length) {
+                if (v.loop) v.position = 0;
+                else v.samples = nullptr;
+            }
+        }
+        v.gainL = targetL; v.gainR = targetR;
+    }
+    a.peakVoices = std::max(a.peakVoices, active);
+
+    for (int i = 0; i < AUDIO_BUFFER_FRAMES; ++i) {
+        a.output[i * 2] = (int16_t)(glm::clamp(a.mixL[i], -1.0f, 1.0f) * 32767.0f);
+        a.output[i * 2 + 1] = (int16_t)(glm::clamp(a.mixR[i], -1.0f, 1.0f) * 32767.0f);
+    }
+}
+
+void writeLE(std::ostream& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.put((char)((value >> (8 * i)) & 0xFF));
+}
+
+// Cabeçalho PCM 16 bits estéreo; os tamanhos são corrigidos em stopAudio
+void writeWavHeader(std::ostream& out, uint32_t frames) {
+    uint32_t dataBytes = frames * 4;
+    out.write("RIFF", 4); writeLE(out, 36 + dataBytes, 4); out.write("WAVE", 4);
+    out.write("fmt ", 4); writeLE(out, 16, 4); writeLE(out, 1, 2); writeLE(out, 2, 2);
+    writeLE(out, AUDIO_RATE, 4); writeLE(out, AUDIO_RATE * 4, 4); writeLE(out, 4, 2); writeLE(out, 16, 2);
+    out.write("data", 4); writeLE(out, dataBytes, 4);
+}
+
+void writeAudioOutput(AudioMixer& a) {
+    if (a.outputMode != AUDIO_OUTPUT_WAV || !a.wav) return;
+    for (int i = 0; i < AUDIO_BUFFER_FRAMES * 2; ++i) writeLE(a.wav, (uint16_t)a.output[i], 2);
+    a.wavFrames += AUDIO_BUFFER_FRAMES;
+}
+
+// Sem placa de som quem dá o ritmo é o relógio: um buffer a cada AUDIO_BUFFER_FRAMES / AUDIO_RATE segundos
+void audioThread() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::microseconds(AUDIO_BUFFER_FRAMES * 1000000LL / AUDIO_RATE);
+    Clock::time_point next = Clock::now();
+    while (g_audio.running.load(std::memory_order_acquire)) {
+        Clock::time_point start = Clock::now();
+        mixAudioBuffer(g_audio);
+        float us = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+        g_audio.mixUs = us;
+        g_audio.mixUsSum += us; g_audio.mixUsMax = std::max(g_audio.mixUsMax, (double)us);
+        g_audio.buffers++;
+        writeAudioOutput(g_audio);
+
+        next += period;
+        if (Clock::now() - next > period * 4) next = Clock::now(); // Atrasou demais (ex.: depurador): não tenta recuperar
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void startAudio() {
+    if (g_audio.outputMode == AUDIO_OUTPUT_OFF) return;
+    synthesizeSounds(g_audio);
+    if (g_audio.outputMode == AUDIO_OUTPUT_WAV) {
+        g_audio.wav.open(g_audio.wavPath, std::ios::binary);
+        if (g_audio.wav) writeWavHeader(g_audio.wav, 0);
+        else std::cout << "Nao foi possivel criar " << g_audio.wavPath << "; audio sem saida" << std::endl;
+    }
+    g_audio.running = true;
+    g_audio.thread = std::thread(audioThread);
+}
+
+void stopAudio() {
+    if (!g_audio.thread.joinable()) return;
+    g_audio.running.store(false, std::memory_order_release);
+    g_audio.thread.join();
+    if (g_audio.wav) {
+        g_audio.wav.seekp(0);
+        writeWavHeader(g_audio.wav, g_audio.wavFrames);
+        g_audio.wav.close();
+    }
+}
+
+void printAudioStats() {
+    if (g_audio.buffers == 0) return;
+    double bufferUs = AUDIO_BUFFER_FRAMES * 1.0e6 / AUDIO_RATE;
+    double meanUs = g_audio.mixUsSum / g_audio.buffers;
+    std::cout << "Audio: " << g_audio.buffers << " buffers de " << AUDIO_BUFFER_FRAMES << " quadros, mixagem media "
+              << meanUs << " us (" << 100.0 * meanUs / bufferUs << "% do tempo real), max " << g_audio.mixUsMax << " us, "
+              << g_audio.peakVoices << " vozes no pico, " << g_audio.stolenVoices << " roubadas, "
+              << g_audio.dropped.load() << " comandos descartados" << std::endl;
+}
+
+
+// --- PARTÍCULAS ---
+// Confete no gol, spray de grama no chute e poeira na rede. A simulação só empilha rajadas (ParticleBurst) numa
+// fila sem lock; a thread de render cria as partículas num anel de PARTICLE_CAPACITY posições, guardadas como
+// fluxos separados (SoA) de um vec4 por partícula: posição + vida, velocidade, parâmetros e cor. Os mesmos fluxos
+// são os buffers da GPU: com GL 4.3 um compute shader integra tudo no lugar; sem ele (ou com --particles-cpu) o
+// CPU integra com SSE e envia só as posições. O desenho é um único glDrawArraysInstanced por câmera, com os fluxos
+// como atributos por instância (billboards com blend alfa sobre a cena, sem OIT).
+const int PARTICLE_CAPACITY = 131072;
+const int PARTICLE_GROUP = 256;        // local_size_x do compute shader
+const int PARTICLE_RECORDS = 512;      // Frames de criação lembrados para estimar quantas ainda vivem
+
+enum ParticleKind { PARTICLE_CONFETTI, PARTICLE_GRASS, PARTICLE_NET_PUFF, PARTICLE_KIND_COUNT };
+
+struct ParticleKindInfo {
+    int perBurst;              // Orçamento de partículas de uma rajada
+    float duration;            // Segundos em que a rajada é emitida (0 = tudo no mesmo frame)
+    float lifeMin, lifeMax;
+    float speed, spread;       // Velocidade inicial e abertura do cone em volta da direção
+    float drag, gravity;       // Arrasto (1/s) e fração da gravidade (negativa sobe)
+    float size;                // Meia aresta do billboard (m)
+};
+const ParticleKindInfo g_particleKinds[PARTICLE_KIND_COUNT] = {
+    {60000, 2.0f, 4.0f, 6.0f, 10.0f, 0.5f, 1.2f, 0.25f, 0.05f},  // Confete: lançado das arquibancadas, cai devagar
+    {1500,  0.0f, 0.8f, 1.4f, 4.0f,  0.6f, 0.8f, 1.0f,  0.025f}, // Grama: spray curto no contato do chute
+    {800,   0.0f, 0.6f, 1.0f, 1.5f,  1.0f, 3.0f, -0.05f, 0.06f}, // Rede: poeira que sobe um pouco e some
+};
+
+struct ParticleBurst {
+    ParticleKind kind;
+    glm::vec3 position, direction;
+    Team team; // Cores do confete
+};
+
+struct ParticleEmitter {
+    ParticleBurst burst;
+    int remaining = 0;
+    float rate = 0.0f, carry = 0.0f; // Partículas por segundo e fração acumulada
+};
+
+struct ParticleSystem {
+    static const int MAX_EMITTERS = 16;
+    MpscQueue<ParticleBurst, 64> bursts;
+    std::atomic<unsigned int> droppedBursts{0};
+    ParticleEmitter emitters[MAX_EMITTERS];
+
+    // Fluxos SoA no CPU; no caminho da GPU só guardam as partículas recém-criadas até o upload
+    std::vector<glm::vec4> position;  // xyz + vida restante (s)
+    std::vector<glm::vec4> velocity;  // xyz + 0
+    std::vector<glm::vec4> params;    // arrasto, gravidade, vida total, tamanho
+    std::vector<uint32_t> color;      // RGBA8
+    int next = 0, highWater = 0;      // Próxima posição do anel / maior índice já usado + 1
+    int dirtyStart = 0, dirtyCount = 0; // Arco do anel criado neste frame (vai para a GPU; pode dar a volta no fim)
+
+    struct SpawnRecord { float expiresAt; int count; };
+    SpawnRecord records[PARTICLE_RECORDS] = {};
+    int recordHead = 0;
+    float time = 0.0f, lastMatchTime = 0.0f, expiresAt = 0.0f;
+    int alive = 0;                    // Estimativa (exata no caminho do CPU)
+    uint32_t seed = 20240601u;
+
+    bool gpuSupported = false;
+    GpuBufferArena streams;           // Um buffer só, com os quatro fluxos em faixas
+    GpuSlice positionStream, velocityStream, paramsStream, colorStream;
+    GpuResource vao, drawProgram, updateProgram;
+};
+ParticleSystem g_particles;
+bool g_particlesEnabled = true; // --no-particles
+bool g_particlesCpu = false;  // --particles-cpu: força o caminho SSE mesmo com compute shader
+int g_particleStress = 0;     // Mantém esse tanto de confete vivo (só para benchmark)
+
+const char* particleUpdateComputeShader =
+    "layout (local_size_x = 256) in;\n"
+    "layout (std430, binding = 4) buffer Positions { vec4 positions[]; };\n"
+    "layout (std430, binding = 5) buffer Velocities { vec4 velocities[]; };\n"
+    "layout (std430, binding = 6) readonly buffer Params { vec4 params[]; };\n"
+    "uniform int particleCount;\n"
+    "uniform float deltaTime;\n"
+    "void main()\n"
+    "{\n"
+    "   uint i = gl_GlobalInvocationID.x;\n"
+    "   if (i >= uint(particleCount)) return;\n"
+    "   vec4 p = positions[i];\n"
+    "   if (p.w <= 0.0) return;\n"
+    "   vec4 v = velocities[i];\n"
+    "   vec4 k = params[i];\n"
+    "   v.y -= 9.81 * k.y * deltaTime;\n"
+    "   v.xyz *= max(0.0, 1.0 - k.x * deltaTime);\n"
+    "   p.xyz += v.xyz * deltaTime;\n"
+    "   p.w -= deltaTime;\n"
+    "   if (p.y < 0.0) { p.y = 0.0; v.xyz *= vec3(0.4, -0.2, 0.4); }\n" // Chão: quica pouco e escorrega
+    "   positions[i] = p;\n"
+    "   velocities[i] = v;\n"
+    "}\n\0";
+
+const char* particleVertexShader = "#version 330 core\n"
+    "layout (location = 0) in vec4 particlePosition;\n" // xyz + vida restante
+    "layout (location = 1) in vec4 particleParams;\n"   // arrasto, gravidade, vida total, tamanho
+    "layout (location = 2) in vec4 particleColor;\n"
+    "uniform mat4 view;\n uniform mat4 projection;\n"
+    "out vec4 color;\n out vec2 corner;\n flat out float soft;\n"
+    "void main()\n"
+    "{\n"
+    "   corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;\n"
+    "   soft = particleColor.a < 1.0 ? 1.0 : 0.0;\n"
+    "   if (particlePosition.w <= 0.0) { gl_Position = vec4(0.0, 0.0, -2.0, 1.0); color = vec4(0.0); return; }\n" // Morta: fora do recorte
+    "   vec3 right = vec3(view[0][0], view[1][0], view[2][0]);\n"
+    "   vec3 up = vec3(view[0][1], view[1][1], view[2][1]);\n"
+    "   vec3 world = particlePosition.xyz + (right * corner.x + up * corner.y) * particleParams.w;\n"
+    "   gl_Position = projection * view * vec4(world, 1.0);\n"
+    "   float fade = clamp(particlePosition.w / (0.3 * particleParams.z), 0.0, 1.0);\n" // Some no último terço da vida
+    "   color = vec4(particleColor.rgb, particleColor.a * fade);\n"
+    "}\n\0";
+
+// Translúcidas (poeira) viram discos suaves; as opacas (confete, grama) ficam quadradas
+const char* particleFragmentShader = "#version 330 core\n"
+    "in vec4 color;\n in vec2 corner;\n flat in float soft;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   float edge = soft > 0.5 ? clamp(1.0 - dot(corner, corner), 0.0, 1.0) : 1.0;\n"
+    "   if (color.a * edge < 0.01) discard;\n"
+    "   FragColor = vec4(color.rgb, color.a * edge);\n"
+    "}\n\0";
+
+// Chamado pela simulação (qualquer thread): nunca bloqueia
+void emitParticles(ParticleKind kind, glm::vec3 position, glm::vec3 direction) {
+    if (!g_particlesEnabled) return;
+    ParticleBurst burst;
+    burst.kind = kind; burst.position = position; burst.direction = direction; burst.team = g_currentKicker;
+    if (!g_particles.bursts.push(burst)) g_particles.droppedBursts.fetch_add(1, std::memory_order_relaxed);
+}
+
+float particleRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32_t packColor(glm::vec4 c) {
+    glm::vec4 v = glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f;
+    return (uint32_t)v.r | ((uint32_t)v.g << 8) | ((uint32_t)v.b << 16) | ((uint32_t)v.a << 24);
+}
+
+void spawnParticle(ParticleSystem& ps, const ParticleBurst& burst) {
+    const ParticleKindInfo& info = g_particleKinds[burst.kind];
+    uint32_t& seed = ps.seed;
+    int i = ps.next;
+    ps.next = (ps.next + 1) % PARTICLE_CAPACITY; // Anel: com o orçamento estourado, a mais antiga dá lugar
+    ps.highWater = std::max(ps.highWater, i + 1);
+    if (ps.dirtyCount == 0) ps.dirtyStart = i;
+    ps.dirtyCount = std::min(ps.dirtyCount + 1, PARTICLE_CAPACITY);
+
+    glm::vec3 origin = burst.position, direction = burst.direction;
+    glm::vec4 color;
+    switch (burst.kind) {
+    case PARTICLE_CONFETTI: {
+        // Canhões ao longo das duas arquibancadas, atirando para cima e para o campo
+        float side = particleRandom(seed) < 0.5f ? -1.0f : 1.0f;
+        origin = glm::vec3(side * 12.0f, 3.0f, -11.0f + 22.0f * particleRandom(seed));
+        direction = glm::vec3(-side * 0.35f, 1.0f, 0.0f);
+        float pick = particleRandom(seed);
+        glm::vec4 teamColor = burst.team == TEAM_1 ? g_team1Color2 : g_team2Color1;
+        color = pick < 0.5f ? teamColor : (pick < 0.75f ? glm::vec4(1.0f, 0.8f, 0.1f, 1.0f) : glm::vec4(0.95f, 0.95f, 0.95f, 1.0f));
+        break;
+    }
+    case PARTICLE_GRASS:
+        color = glm::vec4(0.15f + 0.1f * particleRandom(seed), 0.45f + 0.2f * particleRandom(seed), 0.1f, 1.0f);
+        break;
+    default:
+        color = glm::vec4(0.9f, 0.9f, 0.85f, 0.35f);
+        break;
+    }
+    glm::vec3 jitter(particleRandom(seed) - 0.5f, particleRandom(seed) - 0.5f, particleRandom(seed) - 0.5f);
+    glm::vec3 velocity = glm::normalize(direction + jitter * (2.0f * info.spread)) * info.speed * (0.6f + 0.4f * particleRandom(seed));
+    float life = info.lifeMin + (info.lifeMax - info.lifeMin) * particleRandom(seed);
+
+    ps.position[i] = glm::vec4(origin, life);
+    ps.velocity[i] = glm::vec4(velocity, 0.0f);
+    ps.params[i] = glm::vec4(info.drag, info.gravity, life, info.size * (0.7f + 0.6f * particleRandom(seed)));
+    ps.color[i] = packColor(color);
+}
+
+// Rajadas novas viram emissores; cada emissor solta a sua cota deste frame
+void runParticleEmitters(ParticleSystem& ps, float deltaTime) {
+    ParticleBurst burst;
+    while (ps.bursts.pop(burst)) {
+        ParticleEmitter* slot = nullptr;
+        for (ParticleEmitter& e : ps.emitters) if (e.remaining <= 0) { slot = &e; break; }
+        if (!slot) { ps.droppedBursts.fetch_add(1, std::memory_order_relaxed); continue; }
+        const ParticleKindInfo& info = g_particleKinds[burst.kind];
+        slot->burst = burst; slot->remaining = info.perBurst;
+        // Sem duração: a rajada inteira sai neste frame
+        slot->rate = info.duration > 0.0f ? info.perBurst / info.duration : 0.0f;
+        slot->carry = info.duration > 0.0f ? 0.0f : (float)info.perBurst;
+    }
+    // Benchmark: repõe confete para manter g_particleStress vivas (no máximo 1/30 por frame)
+    if (g_particleStress > 0 && ps.alive < g_particleStress) {
+        ParticleBurst stress;
+        stress.kind = PARTICLE_CONFETTI; stress.position = glm::vec3(0.0f); stress.direction = glm::vec3(0.0f, 1.0f, 0.0f); stress.team = TEAM_1;
+        int count = std::min(g_particleStress - ps.alive, g_particleStress / 30 + 1);
+        for (int i = 0; i < count; ++i) spawnParticle(ps, stress);
+        ps.records[ps.recordHead] = {ps.time + g_particleKinds[PARTICLE_CONFETTI].lifeMax, count};
+        ps.recordHead = (ps.recordHead + 1) % PARTICLE_RECORDS;
+        ps.expiresAt = std::max(ps.expiresAt, ps.time + g_particleKinds[PARTICLE_CONFETTI].lifeMax);
+    }
+    for (ParticleEmitter& e : ps.emitters) {
+        if (e.remaining <= 0) continue;
+        e.carry += e.rate * deltaTime;
+        int count = std::min(e.remaining, (int)e.carry);
+        e.carry -= count; e.remaining -= count;
+        for (int i = 0; i < count; ++i) spawnParticle(ps, e.burst);
+        float expires = ps.time + g_particleKinds[e.burst.kind].lifeMax;
+        ps.records[ps.recordHead] = {expires, count};
+        ps.recordHead = (ps.recordHead + 1) % PARTICLE_RECORDS;
+        ps.expiresAt = std::max(ps.expiresAt, expires);
+    }
+}
+
+// Caminho do CPU: um vec4 por registrador (posição += velocidade * dt e vida -= dt na mesma soma)
+void integrateParticlesCpu(ParticleSystem& ps, float deltaTime) {
+    int alive = 0;
+    for (int i = 0; i < ps.highWater; ++i) {
+        glm::vec4& p = ps.position[i];
+        if (p.w <= 0.0f) continue;
+        glm::vec4& v = ps.velocity[i];
+        const glm::vec4& k = ps.params[i];
+        float damping = std::max(0.0f, 1.0f - k.x * deltaTime);
+#ifdef PARTICLE_SSE
+        __m128 vel = _mm_loadu_ps(&v.x);
+        vel = _mm_sub_ps(vel, _mm_set_ps(0.0f, 0.0f, 9.81f * k.y * deltaTime, 0.0f));
+        vel = _mm_mul_ps(vel, _mm_set_ps(0.0f, damping, damping, damping));
+        __m128 pos = _mm_add_ps(_mm_loadu_ps(&p.x), _mm_mul_ps(vel, _mm_set1_ps(deltaTime)));
+        pos = _mm_sub_ps(pos, _mm_set_ps(deltaTime, 0.0f, 0.0f, 0.0f));
+        _mm_storeu_ps(&v.x, vel);
+        _mm_storeu_ps(&p.x, pos);
+#else
+        v.y -= 9.81f * k.y * deltaTime;
+        v = glm::vec4(glm::vec3(v) * damping, 0.0f);
+        p += glm::vec4(glm::vec3(v) * deltaTime, -deltaTime);
+#endif
+        if (p.y < 0.0f) { p.y = 0.0f; v.x *= 0.4f; v.y *= -0.2f; v.z *= 0.4f; }
+        if (p.w > 0.0f) alive++;
+    }
+    ps.alive = alive;
+}
+
+bool particlesOnGpu() { return g_particles.gpuSupported && !g_particlesCpu; }
+
+// Envia as partículas [begin, end) do anel; posição e velocidade só no caminho da GPU
+void uploadParticleRange(const ParticleSystem& ps, bool gpu, int begin, int end) {
+    if (end <= begin) return;
+    GLintptr offset = begin * sizeof(glm::vec4);
+    GLsizeiptr count = end - begin;
+    bindBuffer(GL_ARRAY_BUFFER, ps.streams.buffer);
+    if (gpu) {
+        glBufferSubData(GL_ARRAY_BUFFER, ps.positionStream.offset + offset, count * sizeof(glm::vec4), &ps.position[begin]);
+        glBufferSubData(GL_ARRAY_BUFFER, ps.velocityStream.offset + offset, count * sizeof(glm::vec4), &ps.velocity[begin]);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, ps.paramsStream.offset + offset, count * sizeof(glm::vec4), &ps.params[begin]);
+    glBufferSubData(GL_ARRAY_BUFFER, ps.colorStream.offset + begin * sizeof(uint32_t), count * sizeof(uint32_t), &ps.color[begin]);
+}
+
+// Uma vez por frame, antes das câmeras: emite, integra e deixa os buffers prontos para o desenho.
+// O passo é o tempo de partida (g_matchTime) avançado desde o último frame: segue a simulação e o --bench.
+void updateParticles() {
+    ParticleSystem& ps = g_particles;
+    float deltaTime = glm::clamp(g_matchTime - ps.lastMatchTime, 0.0f, 0.1f);
+    ps.lastMatchTime = g_matchTime;
+    ps.time += deltaTime;
+    runParticleEmitters(ps, deltaTime);
+
+    if (ps.time > ps.expiresAt && ps.highWater > 0) { ps.next = 0; ps.highWater = 0; } // Todas morreram: anel volta ao início
+    bool gpu = particlesOnGpu();
+    if (gpu) {
+        int alive = 0;
+        for (const ParticleSystem::SpawnRecord& r : ps.records) if (r.expiresAt > ps.time) alive += r.count;
+        ps.alive = std::min(alive, PARTICLE_CAPACITY);
+    }
+    if (ps.dirtyCount > 0) {
+        // Partículas novas: só o arco criado neste frame vai para a GPU (no CPU as posições vão inteiras abaixo).
+        // Se o anel deu a volta, são duas faixas; as vivas fora delas seguem com o estado que só a GPU tem.
+        int firstEnd = std::min(ps.dirtyStart + ps.dirtyCount, PARTICLE_CAPACITY);
+        uploadParticleRange(ps, gpu, ps.dirtyStart, firstEnd);
+        uploadParticleRange(ps, gpu, 0, ps.dirtyStart + ps.dirtyCount - firstEnd);
+        ps.dirtyCount = 0;
     }
+    if (ps.highWater == 0) { ps.alive = 0; return; }
+
+    if (gpu) {
+        useProgram(ps.updateProgram);
+        setUniform1i("particleCount", ps.highWater);
+        setUniform1f("deltaTime", deltaTime);
+        const GpuSlice* streams[3] = { &ps.positionStream, &ps.velocityStream, &ps.paramsStream };
+        for (int i = 0; i < 3; ++i) glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 4 + i, streams[i]->buffer, streams[i]->offset, streams[i]->size);
+        glDispatchCompute((ps.highWater + PARTICLE_GROUP - 1) / PARTICLE_GROUP, 1, 1);
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT); // Desenho e próximos uploads veem as escritas
+    } else {
+        integrateParticlesCpu(ps, deltaTime);
+        bindBuffer(GL_ARRAY_BUFFER, ps.streams.buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, ps.positionStream.offset, ps.highWater * sizeof(glm::vec4), ps.position.data());
+    }
+    g_frameStats.particles = ps.alive;
+}
+
+// Um draw instanciado por câmera (depois dos opacos e translúcidos da cena)
+void drawParticles(const glm::mat4& view, const glm::mat4& projection) {
+    ParticleSystem& ps = g_particles;
+    if (ps.highWater == 0) return;
+    setCapability(GL_DEPTH_TEST, true);
+    setDepthMask(false);
+    setCapability(GL_BLEND, true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    useProgram(ps.drawProgram);
+    setUniformMatrix4("view", view);
+    setUniformMatrix4("projection", projection);
+    bindVertexArray(ps.vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, ps.highWater);
+    g_frameStats.drawCalls++;
+}
+
+void createParticles() {
+    ParticleSystem& ps = g_particles;
+    ps.position.assign(PARTICLE_CAPACITY, glm::vec4(0.0f));
+    ps.velocity.assign(PARTICLE_CAPACITY, glm::vec4(0.0f));
+    ps.params.assign(PARTICLE_CAPACITY, glm::vec4(0.0f));
+    ps.color.assign(PARTICLE_CAPACITY, 0u);
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major); glGetIntegerv(GL_MINOR_VERSION, &minor);
+    ps.gpuSupported = major * 10 + minor >= 43;
+    if (ps.gpuSupported) ps.updateProgram = compileComputeProgram({ "#version 430 core\n", particleUpdateComputeShader });
+    ps.drawProgram = compileProgram({ particleVertexShader }, { particleFragmentShader });
+
+    // Fluxos alinhados para glBindBufferRange dos SSBOs; vidas zeradas: tudo começa morto
+    GLint alignment = 256;
+    if (ps.gpuSupported) glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    size_t align = std::max<size_t>(256, alignment), streamBytes = PARTICLE_CAPACITY * sizeof(glm::vec4);
+    createBufferArena(ps.streams, GPU_CAT_EFFECTS, 3 * streamBytes + PARTICLE_CAPACITY * sizeof(uint32_t) + 4 * align, GL_DYNAMIC_DRAW, "particulas");
+    ps.positionStream = suballocate(ps.streams, streamBytes, align, ps.position.data());
+    ps.velocityStream = suballocate(ps.streams, streamBytes, align, ps.velocity.data());
+    ps.paramsStream = suballocate(ps.streams, streamBytes, align, ps.params.data());
+    ps.colorStream = suballocate(ps.streams, PARTICLE_CAPACITY * sizeof(uint32_t), align, ps.color.data());
+    ps.vao = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_EFFECTS, "VAO particulas");
+    glBindVertexArray(ps.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, ps.streams.buffer);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)ps.positionStream.offset); glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)ps.paramsStream.offset); glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), (void*)ps.colorStream.offset); glEnableVertexAttribArray(2);
+    for (int i = 0; i < 3; ++i) glVertexAttribDivisor(i, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void destroyParticles() {
+    ParticleSystem& ps = g_particles;
+    ps.streams.buffer.reset();
+    ps.vao.reset();
+    ps.drawProgram.reset();
+    ps.updateProgram.reset();
+}
+
+// Mata tudo sem tocar na GPU (as vidas antigas ficam além de highWater e não são desenhadas)
+void clearParticles() {
+    ParticleSystem& ps = g_particles;
+    ParticleBurst burst;
+    while (ps.bursts.pop(burst)) {}
+    for (ParticleEmitter& e : ps.emitters) e.remaining = 0;
+    for (ParticleSystem::SpawnRecord& r : ps.records) r = {0.0f, 0};
+    ps.next = 0; ps.highWater = 0; ps.alive = 0;
+    ps.time = 0.0f; ps.expiresAt = 0.0f; ps.lastMatchTime = 0.0f;
+    ps.dirtyCount = 0;
 }
 
 
@@ -809,304 +2898,3316 @@ bool checkCollision(glm::vec3 pos1, glm::vec3 size1, glm::vec3 pos2, float radiu
     return distance < radius2;
 }
 void printKickMessage() {
-    std::cout << "\n--- Vez do Time " << (g_currentKicker == TEAM_1 ? "1 (Listrado)" : "2 (Azul)") << " ---" << std::endl;
-    std::cout << "Chute " << (g_currentKick / 2) + 1 << " de 3.\n" << std::endl;
-    std::cout << "Escolha onde chutar:\n" << "1) Meio\n" << "2) Direita (Canto)\n" << "3) Esquerda (Canto)\n"
-              << "--------------------------------" << std::endl;
+    logEvent(EVT_KICK_PROMPT);
 }
 void printFinalScore() {
     int score1 = 0; int score2 = 0;
     for(int r : g_team1Results) if(r == 1) score1++;
     for(int r : g_team2Results) if(r == 1) score2++;
-    std::cout << "\n\n======= FIM DE JOGO! =======" << std::endl;
-    std::cout << "  Placar Final: \n" << "  Time 1 (Listrado): " << score1 << "\n" << "  Time 2 (Azul):     " << score2 << std::endl;
-    if (score1 > score2) std::cout << "  Time 1 VENCEU!" << std::endl;
-    else if (score2 > score1) std::cout << "  Time 2 VENCEU!" << std::endl;
-    else std::cout << "  EMPATE!" << std::endl;
-    std::cout << "===========================" << std::endl;
+    logEvent(EVT_FINAL_SCORE, score1, score2);
 }
+
+// Entrada do jogo: produzida pelo teclado e pelos roteiros do benchmark, consumida só por updateGame
+struct GameInput {
+    int kick;    // 1..3
+    double time; // Quando a tecla chegou (glfwGetTime), para medir a latência; 0 = sem medição
+};
+MpscQueue<GameInput, 64> g_inputQueue;
+
+void requestKick(int choice, double time = 0.0) { g_inputQueue.push({ choice, time }); }
+
 void key_callback(GLFWwindow* window, int key, int scode, int action, int mods) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) { glfwSetWindowShouldClose(window, true); }
-    if (g_gameState == STATE_READY && action == GLFW_PRESS) {
-        if (key == GLFW_KEY_1) g_kickRequest = 1;
-        else if (key == GLFW_KEY_2) g_kickRequest = 2;
-        else if (key == GLFW_KEY_3) g_kickRequest = 3;
+    if (key == GLFW_KEY_V && action == GLFW_PRESS) { g_multiView = !g_multiView; }
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) { g_showHud = !g_showHud; }
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) { g_occlusionCulling = !g_occlusionCulling; }
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) { g_gpuDriven = !g_gpuDriven; }
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) { g_grass = !g_grass; }
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) { g_gpuReportRequest = true; }
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        g_lowLatency = !g_lowLatency;
+        logEvent(EVT_SETTING, SETTING_LOW_LATENCY, g_lowLatency ? 1 : 0);
+    }
+    if (key == GLFW_KEY_R && action == GLFW_PRESS) { g_textureReportRequest = true; }
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        g_transparencyMode = (g_transparencyMode == TRANSPARENCY_OIT) ? TRANSPARENCY_SORTED : TRANSPARENCY_OIT;
+        logEvent(EVT_SETTING, SETTING_TRANSPARENCY, g_transparencyMode);
+    }
+    if (g_gameState == STATE_READY && action == GLFW_PRESS && key >= GLFW_KEY_1 && key <= GLFW_KEY_3) {
+        requestKick(key - GLFW_KEY_1 + 1, glfwGetTime());
     }
 }
 
 
-// --- PROGRAMA PRINCIPAL ---
-int main() {
-    // --- INICIALIZAÇÃO ---
-    assert(glfwInit() == GLFW_TRUE);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Disputa de Penaltis 3D (v5 Animado)", nullptr, nullptr);
-    assert(window);
-    glfwMakeContextCurrent(window);
-    glfwSetKeyCallback(window, key_callback);
-    assert(glewInit() == GLEW_OK);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // --- COMPILAÇÃO DOS SHADERS DE ILUMINAÇÃO ---
-    unsigned int shaderProgram = glCreateProgram();
-    {
-        unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &lightingVertexShader, NULL); glCompileShader(vertexShader);
-        unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &lightingFragmentShader, NULL); glCompileShader(fragmentShader);
-        glAttachShader(shaderProgram, vertexShader); glAttachShader(shaderProgram, fragmentShader);
-        glLinkProgram(shaderProgram);
-        glDeleteShader(vertexShader); glDeleteShader(fragmentShader);
+// --- LÓGICA DO JOGO ---
+// Avança a simulação em deltaTime segundos (máquina de estados, física da bola e do goleiro).
+void updateGame(float deltaTime) {
+    g_kickInputTime = 0.0;
+    GameInput input;
+    while (g_inputQueue.pop(input)) {
+        if (g_gameState != STATE_READY) continue; // Tecla atrasada (o render vê o estado de um passo antes)
+        g_sim.kickRequest = input.kick; g_kickInputTime = input.time;
     }
-    
-    // --- CRIAÇÃO DAS GEOMETRIAS ---
-    unsigned int cubeVAO = createCubeVAO();
-    std::pair<unsigned int, int> sphereData = createSphereVAO(1.0f, 32, 16);
-    unsigned int sphereVAO = sphereData.first;
-    int sphereIndexCount = sphereData.second;
-    std::pair<unsigned int, int> cylinderData = createCylinderVAO(1.0f, 1.0f, 24);
-    unsigned int cylinderVAO = cylinderData.first;
-    int cylinderIndexCount = cylinderData.second;
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-    glfwSetCursorPosCallback(window, cursor_position_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    updateCamera();
-    
-    printKickMessage();
-    float lastFrameTime = 0.0f;
-
-    // --- LOOP PRINCIPAL DE RENDERIZAÇÃO ---
-    while (!glfwWindowShouldClose(window)) {
-        float currentFrameTime = glfwGetTime();
-        float deltaTime = currentFrameTime - lastFrameTime;
-        lastFrameTime = currentFrameTime;
-
-        // --- LÓGICA DE ATUALIZAÇÃO ---
-        glfwPollEvents();
-        
-        // ... (TODA A SUA LÓGICA DE JOGO VEM AQUI) ...
-
-        if (g_netAnimationTimer > 0.0f) { g_netAnimationTimer -= deltaTime; }
-        if (g_gameState == STATE_RUNNING_UP || g_gameState == STATE_KICKING || g_keeperState == KEEPER_DIVING || g_gameState == STATE_GOAL) {
-            g_animationTimer += deltaTime;
+    g_matchTime += deltaTime;
+    if (g_netAnimationTimer > 0.0f) { g_netAnimationTimer -= deltaTime; }
+    if (g_gameState == STATE_RUNNING_UP || g_gameState == STATE_KICKING || g_keeperState == KEEPER_DIVING || g_gameState == STATE_GOAL) {
+        g_animationTimer += deltaTime;
+    }
+    if (g_gameState != STATE_GAMEOVER) {
+        if (g_gameState == STATE_READY && g_sim.kickRequest != 0) {
+            setGameState(STATE_RUNNING_UP);
+            g_animationTimer = 0.0f;
+            logEvent(EVT_RUN_UP);
         }
-        if (g_gameState != STATE_GAMEOVER) {
-            if (g_gameState == STATE_READY && g_kickRequest != 0) {
-                g_gameState = STATE_RUNNING_UP;
+        if (g_gameState == STATE_RUNNING_UP) {
+            glm::vec2 playerPosXZ(g_playerPosition.x, g_playerPosition.z);
+            glm::vec2 ballPosXZ(g_ballPosition.x, g_ballPosition.z);
+            glm::vec2 directionXZ = glm::normalize(ballPosXZ - playerPosXZ);
+            g_playerPosition.x += directionXZ.x * g_playerRunSpeed * deltaTime;
+            g_playerPosition.z += directionXZ.y * g_playerRunSpeed * deltaTime;
+            if (glm::distance(playerPosXZ, ballPosXZ) < 0.5f) {
+                g_playerPosition.x = g_ballPosition.x - directionXZ.x * 0.5f;
+                g_playerPosition.z = g_ballPosition.z - directionXZ.y * 0.5f;
+                setGameState(STATE_KICKING);
                 g_animationTimer = 0.0f;
-                std::cout << "Jogador correndo..." << std::endl;
+                logEvent(EVT_KICK, g_sim.kickRequest);
+                playSound(SOUND_KICK, g_ballPosition);
+                emitParticles(PARTICLE_GRASS, glm::vec3(g_ballPosition.x, 0.02f, g_ballPosition.z), glm::vec3(0.0f, 1.0f, -0.6f));
+                float targetX = 0.0f;
+                if (g_sim.kickRequest == 2) targetX = (g_goalWidth / 2.0f) * 0.8f;
+                if (g_sim.kickRequest == 3) targetX = -(g_goalWidth / 2.0f) * 0.8f;
+                glm::vec3 kickDirection = glm::vec3(targetX, 0.5f, g_keeperPosition.z) - g_ballPosition;
+                g_sim.ballVelocity = glm::normalize(kickDirection) * g_ballSpeed;
+                int choice = g_keeperChoice(g_randomEngine);
+                logEvent(EVT_KEEPER_CHOICE, choice);
+                float keeperTargetX = 0.0f;
+                if (choice == 1) keeperTargetX = -(g_goalWidth / 2.0f) * 0.8f;
+                if (choice == 3) keeperTargetX = (g_goalWidth / 2.0f) * 0.8f;
+                g_keeperTargetPos = glm::vec3(keeperTargetX, g_keeperPosition.y, g_keeperPosition.z);
+                g_keeperState = KEEPER_DIVING;
+                g_animationTimer = 0.0f; 
+                g_sim.kickRequest = 0;
             }
-            if (g_gameState == STATE_RUNNING_UP) {
-                glm::vec2 playerPosXZ(g_playerPosition.x, g_playerPosition.z);
-                glm::vec2 ballPosXZ(g_ballPosition.x, g_ballPosition.z);
-                glm::vec2 directionXZ = glm::normalize(ballPosXZ - playerPosXZ);
-                g_playerPosition.x += directionXZ.x * g_playerRunSpeed * deltaTime;
-                g_playerPosition.z += directionXZ.y * g_playerRunSpeed * deltaTime;
-                if (glm::distance(playerPosXZ, ballPosXZ) < 0.5f) {
-                    g_playerPosition.x = g_ballPosition.x - directionXZ.x * 0.5f;
-                    g_playerPosition.z = g_ballPosition.z - directionXZ.y * 0.5f;
-                    g_gameState = STATE_KICKING;
-                    g_animationTimer = 0.0f;
-                    std::cout << "CHUTOU!" << std::endl;
-                    float targetX = 0.0f;
-                    if (g_kickRequest == 2) targetX = (g_goalWidth / 2.0f) * 0.8f;
-                    if (g_kickRequest == 3) targetX = -(g_goalWidth / 2.0f) * 0.8f;
-                    glm::vec3 kickDirection = glm::vec3(targetX, 0.5f, g_keeperPosition.z) - g_ballPosition;
-                    g_ballVelocity = glm::normalize(kickDirection) * g_ballSpeed;
-                    int choice = g_keeperChoice(g_randomEngine);
-                    float keeperTargetX = 0.0f;
-                    if (choice == 1) keeperTargetX = -(g_goalWidth / 2.0f) * 0.8f;
-                    if (choice == 3) keeperTargetX = (g_goalWidth / 2.0f) * 0.8f;
-                    g_keeperTargetPos = glm::vec3(keeperTargetX, g_keeperPosition.y, g_keeperPosition.z);
-                    g_keeperState = KEEPER_DIVING;
-                    g_animationTimer = 0.0f; 
-                    g_kickRequest = 0;
-                }
+        }
+        if (g_gameState == STATE_KICKING) {
+            if (g_animationTimer > 0.3f) {
+                setGameState(STATE_BALL_IN_FLIGHT);
             }
-            if (g_gameState == STATE_KICKING) {
-                if (g_animationTimer > 0.3f) {
-                    g_gameState = STATE_BALL_IN_FLIGHT; 
-                }
+        }
+        if (g_gameState == STATE_BALL_IN_FLIGHT) {
+            // Atualiza posição da bola
+            g_ballPosition += g_sim.ballVelocity * deltaTime;
+            int currentKickIndex = g_currentKick / 2;
+
+            // 1) Colisão com goleiro (prioridade)
+            if (checkCollision(g_keeperPosition, g_keeperTorsoSize, g_ballPosition, g_ballRadius) && !g_sim.goalRecorded) {
+                // Defesa do goleiro: rebate para frente (em direção ao jogador)
+                setGameState(STATE_SAVED);
+                // Mantém componente X mas reduz, e inverte Z para ir para frente do campo
+                g_sim.ballVelocity = glm::vec3(g_sim.ballVelocity.x * 0.3f, std::max(0.1f, g_sim.ballVelocity.y * 0.2f), 2.5f);
+                // Aumenta um pouco o tempo de rebote para a animação ficar visível
+                g_sim.reboundTimer = 0.8f;
+                logEvent(EVT_SAVE);
+                playSound(SOUND_SAVE, g_ballPosition);
+                if (g_currentKicker == TEAM_1) g_team1Results[currentKickIndex] = 2; else g_team2Results[currentKickIndex] = 2;
+                g_currentKick++;
             }
-            if (g_gameState == STATE_BALL_IN_FLIGHT) {
-                // Atualiza posição da bola
-                g_ballPosition += g_ballVelocity * deltaTime;
-                int currentKickIndex = g_currentKick / 2;
-
-                // 1) Colisão com goleiro (prioridade)
-                if (checkCollision(g_keeperPosition, g_keeperTorsoSize, g_ballPosition, g_ballRadius) && !g_goalRecorded) {
-                    // Defesa do goleiro: rebate para frente (em direção ao jogador)
-                    g_gameState = STATE_SAVED;
-                    // Mantém componente X mas reduz, e inverte Z para ir para frente do campo
-                    g_ballVelocity = glm::vec3(g_ballVelocity.x * 0.3f, std::max(0.1f, g_ballVelocity.y * 0.2f), 2.5f);
-                    // Aumenta um pouco o tempo de rebote para a animação ficar visível
-                    g_reboundTimer = 0.8f;
-                    std::cout << "DEFENDEU!!!" << std::endl;
-                    if (g_currentKicker == TEAM_1) g_team1Results[currentKickIndex] = 2; else g_team2Results[currentKickIndex] = 2;
-                    g_currentKick++;
-                }
-                else {
-                    // 2) Verifica se cruzou a linha do gol (entrada no arco)
-                    if (!g_goalRecorded && g_ballPosition.z < g_goalLineZ) {
-                        bool insideWidth = std::abs(g_ballPosition.x) <= (g_goalWidth / 2.0f);
-                        bool underCrossbar = g_ballPosition.y <= g_goalHeight;
-                        if (insideWidth && underCrossbar) {
-                            // Marca gol (a bola segue até a rede traseira)
-                            g_goalRecorded = true;
-                            g_gameState = STATE_GOAL; // <-- MUDA O ESTADO
-                            // define tempo para a animação da rede e para manter o estado antes do reset
-                            g_netAnimationTimer = 0.5f;
-                            g_resetTimer = 2.5f; // <-- importante: dá tempo para bola chegar na rede e animação
-                            if (g_currentKicker == TEAM_1) g_team1Results[currentKickIndex] = 1; else g_team2Results[currentKickIndex] = 1;
-                            std::cout << "GOOOOOOL! Bola entrou no gol (registrado)." << std::endl;
-                            g_currentKick++;
-                            // Deixa a velocidade original para que a bola percorra até a rede traseira
-                        } else {
-                            // Passou a linha mas não dentro do arco => bola perdida (fora)
-                            g_gameState = STATE_RESETTING;
-                            g_resetTimer = 2.0f;
-                            std::cout << "Fora do gol." << std::endl;
-                            g_currentKick++;
-                        }
+            else {
+                // 2) Verifica se cruzou a linha do gol (entrada no arco)
+                if (!g_sim.goalRecorded && g_ballPosition.z < g_goalLineZ) {
+                    bool insideWidth = std::abs(g_ballPosition.x) <= (g_goalWidth / 2.0f);
+                    bool underCrossbar = g_ballPosition.y <= g_goalHeight;
+                    if (insideWidth && underCrossbar) {
+                        // Marca gol (a bola segue até a rede traseira)
+                        g_sim.goalRecorded = true;
+                        setGameState(STATE_GOAL); // <-- MUDA O ESTADO
+                        // define tempo para a animação da rede e para manter o estado antes do reset
+                        g_netAnimationTimer = 0.5f;
+                        g_sim.resetTimer = 2.5f; // <-- importante: dá tempo para bola chegar na rede e animação
+                        if (g_currentKicker == TEAM_1) g_team1Results[currentKickIndex] = 1; else g_team2Results[currentKickIndex] = 1;
+                        logEvent(EVT_GOAL);
+                        playSound(SOUND_GOAL_ROAR, g_ballPosition, 1.0f, false);
+                        emitParticles(PARTICLE_CONFETTI, g_ballPosition, glm::vec3(0.0f, 1.0f, 0.0f));
+                        g_currentKick++;
+                        // Deixa a velocidade original para que a bola percorra até a rede traseira
+                    } else {
+                        // Passou a linha mas não dentro do arco => bola perdida (fora)
+                        setGameState(STATE_RESETTING);
+                        g_sim.resetTimer = 2.0f;
+                        logEvent(EVT_MISS);
+                        // Passou raspando: conta como bola na trave
+                        if (std::abs(std::abs(g_ballPosition.x) - g_goalWidth / 2.0f) < 0.3f || std::abs(g_ballPosition.y - g_goalHeight) < 0.3f)
+                            playSound(SOUND_POST, g_ballPosition);
+                        g_currentKick++;
                     }
-                    
                 }
+                
             }
-            if (g_keeperState == KEEPER_DIVING) {
-                g_keeperPosition.x = glm::mix(g_keeperPosition.x, g_keeperTargetPos.x, g_keeperDiveSpeed * deltaTime);
-                if (std::abs(g_keeperPosition.x - g_keeperTargetPos.x) < 0.1f) {
-                    g_keeperPosition.x = g_keeperTargetPos.x;
-                }
+        }
+        if (g_keeperState == KEEPER_DIVING) {
+            g_keeperPosition.x = glm::mix(g_keeperPosition.x, g_keeperTargetPos.x, g_keeperDiveSpeed * deltaTime);
+            if (std::abs(g_keeperPosition.x - g_keeperTargetPos.x) < 0.1f) {
+                g_keeperPosition.x = g_keeperTargetPos.x;
             }
-            if (g_gameState == STATE_SAVED) {
-                g_reboundTimer -= deltaTime;
-                g_ballPosition += g_ballVelocity * deltaTime;
-                if (g_reboundTimer <= 0.0f) {
-                    g_gameState = STATE_RESETTING; g_resetTimer = 2.0f; g_ballVelocity = glm::vec3(0.0f);
-                }
+        }
+        if (g_gameState == STATE_SAVED) {
+            g_sim.reboundTimer -= deltaTime;
+            g_ballPosition += g_sim.ballVelocity * deltaTime;
+            if (g_sim.reboundTimer <= 0.0f) {
+                setGameState(STATE_RESETTING); g_sim.resetTimer = 2.0f; g_sim.ballVelocity = glm::vec3(0.0f);
             }
-            // 6. ESTADO DE GOL
-            if (g_gameState == STATE_GOAL) {
-                g_ballPosition += g_ballVelocity * deltaTime;
-
-                // (A flag g_goalRecorded já é verdadeira se estamos neste estado)
-                if (g_ballPosition.z < (g_backNetZ + 0.05f)) {
-                    // Trava a bola na rede
-                    g_ballPosition.z = g_backNetZ + 0.05f;
-                    
-                    // Rebate (inverte Z e reduz velocidade)
-                    g_ballVelocity.z = 1.0f;
-                    g_ballVelocity.x *= 0.05f;
-                    g_ballVelocity.y = 0.1f; // Pequeno "pop" para cima
-
-                    // Reduz o tempo de reset, pois a bola já parou
-                    g_resetTimer = 2.0f;
-                }
+        }
+        // 6. ESTADO DE GOL
+        if (g_gameState == STATE_GOAL) {
+            g_ballPosition += g_sim.ballVelocity * deltaTime;
 
-                // Só ativa se a bola estiver vindo para frente (vel Z > 0)
-                if (g_ballVelocity.z > 0 && g_ballPosition.z > (g_goalLineZ - 0.05f)) {
-                    // Trava a bola na linha do gol
-                    g_ballPosition.z = g_goalLineZ - 0.05f;
-                    // Para a bola completamente
-                    g_ballVelocity = glm::vec3(0.0f);
+            // (A flag g_sim.goalRecorded já é verdadeira se estamos neste estado)
+            if (g_ballPosition.z < (g_backNetZ + 0.05f)) {
+                // Trava a bola na rede
+                g_ballPosition.z = g_backNetZ + 0.05f;
+                if (g_sim.ballVelocity.z < 0.0f) {
+                    playSound(SOUND_NET, g_ballPosition);
+                    emitParticles(PARTICLE_NET_PUFF, g_ballPosition, glm::vec3(0.0f, 0.3f, 1.0f));
                 }
+                
+                // Rebate (inverte Z e reduz velocidade)
+                g_sim.ballVelocity.z = 1.0f;
+                g_sim.ballVelocity.x *= 0.05f;
+                g_sim.ballVelocity.y = 0.1f; // Pequeno "pop" para cima
+
+                // Reduz o tempo de reset, pois a bola já parou
+                g_sim.resetTimer = 2.0f;
+            }
+
+            // Só ativa se a bola estiver vindo para frente (vel Z > 0)
+            if (g_sim.ballVelocity.z > 0 && g_ballPosition.z > (g_goalLineZ - 0.05f)) {
+                // Trava a bola na linha do gol
+                g_ballPosition.z = g_goalLineZ - 0.05f;
+                // Para a bola completamente
+                g_sim.ballVelocity = glm::vec3(0.0f);
+            }
+
+            // (Opcional) Mini-gravidade para a bola "cair" no chão após bater
+            if (g_ballPosition.y > g_ballRadius + 0.01f) {
+                g_sim.ballVelocity.y -= 2.0f * deltaTime; 
+            } else {
+                g_ballPosition.y = g_ballRadius;
+                g_sim.ballVelocity.y = 0.0f;
+            }
 
-                // (Opcional) Mini-gravidade para a bola "cair" no chão após bater
-                if (g_ballPosition.y > g_ballRadius + 0.01f) {
-                    g_ballVelocity.y -= 2.0f * deltaTime; 
+            // Apenas decrementar timers;
+            if (g_netAnimationTimer > 0.0f) { g_netAnimationTimer -= deltaTime; }
+            if (g_sim.resetTimer > 0.0f) { g_sim.resetTimer -= deltaTime; }
+            
+            if (g_sim.resetTimer <= 0.0f) {
+                setGameState(STATE_RESETTING);
+                g_netAnimationTimer = 0.0f;
+            }
+        }
+        if (g_gameState == STATE_RESETTING) {
+            if(g_sim.resetTimer > 0.0f) { g_sim.resetTimer -= deltaTime; }
+            if (g_sim.resetTimer <= 0.0f) {
+                if (g_currentKick == 6) {
+                    setGameState(STATE_GAMEOVER); printFinalScore();
                 } else {
-                    g_ballPosition.y = g_ballRadius;
-                    g_ballVelocity.y = 0.0f;
+                    setGameState(STATE_READY); g_keeperState = KEEPER_IDLE; g_animationTimer = 0.0f;
+                    g_currentKicker = (g_currentKicker == TEAM_1) ? TEAM_2 : TEAM_1; 
+                    g_playerPosition = g_playerStartPos;
+                    g_ballPosition = glm::vec3(0.0f, 0.1f, 6.0f); 
+                    g_keeperPosition = glm::vec3(0.0f, 0.8f, -10.0f); 
+                    g_sim.goalRecorded = false; 
+                    printKickMessage();
                 }
+            }
+        }
+    } // Fim do if(STATE_GAMEOVER)
+    followCrowdAudio();
+}
 
-                // Apenas decrementar timers;
-                if (g_netAnimationTimer > 0.0f) { g_netAnimationTimer -= deltaTime; }
-                if (g_resetTimer > 0.0f) { g_resetTimer -= deltaTime; }
-                
-                if (g_resetTimer <= 0.0f) {
-                    g_gameState = STATE_RESETTING;
-                    g_netAnimationTimer = 0.0f;
-                }
+// Volta todo o estado da partida (e da câmera) para o início da disputa.
+void resetMatch() {
+    g_gameState = STATE_READY; g_keeperState = KEEPER_IDLE; g_currentKicker = TEAM_1;
+    g_currentKick = 0;
+    g_team1Results = {0, 0, 0}; g_team2Results = {0, 0, 0};
+    g_playerPosition = g_playerStartPos;
+    g_ballPosition = glm::vec3(0.0f, 0.1f, 6.0f);
+    g_keeperPosition = glm::vec3(0.0f, 0.8f, -10.0f);
+    g_keeperTargetPos = g_keeperPosition;
+    g_sim = SimulationState();
+    GameInput dropped;
+    while (g_inputQueue.pop(dropped)) {} // Sem simulação rodando aqui: a thread principal pode consumir
+    g_netAnimationTimer = 0.0f; g_animationTimer = 0.0f;
+    g_matchTime = 0.0f;
+    g_cameraRadius = 20.0f; g_cameraYaw = glm::radians(45.0f); g_cameraPitch = glm::radians(20.0f);
+    clearParticles();
+}
+
+// Ajustes de renderização da linha de comando. Guardados para o --bench reaplicar por cima da base de cada
+// cenário (o setup do cenário vem depois e só muda o que ele mede). Devolve quantos argumentos consumiu.
+std::vector<std::pair<std::string, std::string>> g_renderOptionArgs;
+
+int applyRenderOption(const std::string& arg, const char* value) {
+    if (arg == "--multiview") g_multiView = true;
+    else if (arg == "--no-occlusion") g_occlusionCulling = false;
+    else if (arg == "--no-gpu-driven") g_gpuDriven = false;
+    else if (arg == "--no-pipeline") g_pipelineMode = PIPELINE_OFF;
+    else if (arg == "--pipeline-bounded") g_pipelineMode = PIPELINE_BOUNDED;
+    else if (arg == "--low-latency") g_lowLatency = true;
+    else if (arg == "--no-dynres") g_dynamicResolution = false;
+    else if (arg == "--sorted-blend") g_transparencyMode = TRANSPARENCY_SORTED;
+    else if (arg == "--particles-cpu") g_particlesCpu = true;
+    else if (arg == "--no-grass") g_grass = false;
+    else if (arg == "--grass-density" && value) { g_grassDensity = glm::clamp((float)std::strtod(value, nullptr), 0.0f, 1.0f); return 2; }
+    else return 0;
+    return 1;
+}
+
+// Base comparável dos cenários do --bench (cargas zeradas, resolução cheia, sem pipeline) + a linha de comando
+void resetBenchSettings() {
+    g_crowdScale = 1;
+    g_translucentStress = 0;
+    g_extraLights = 0;
+    g_particleStress = 0;
+    g_multiView = false;
+    g_transparencyMode = TRANSPARENCY_OIT;
+    g_occlusionCulling = true;
+    g_gpuDriven = true;
+    g_dynamicResolution = false; // Exceto nos cenários de resolução dinâmica
+    g_pipelineMode = PIPELINE_OFF; // Sequencial e determinístico, exceto nos cenários do pipeline
+    g_lowLatency = false;
+    g_particlesCpu = false;
+    g_grass = true; g_grassDensity = 0.35f;
+    for (const std::pair<std::string, std::string>& option : g_renderOptionArgs)
+        applyRenderOption(option.first, option.second.empty() ? nullptr : option.second.c_str());
+}
+
+// Cubo, esfera e cilindro num único VAO (ver GEOMETRIA): trocar de malha é só mudar a faixa de índices.
+// Vértices e índices são faixas do buffer de geometria estática (ver RECURSOS DA GPU).
+struct SceneMeshes {
+    GpuResource vao;
+    GpuSlice vertices, indices;
+    MeshRange ranges[MESH_COUNT];
+};
+
+// Vértices (atributos 0 e 1) e índices das malhas no VAO ligado; o VAO do caminho na GPU usa o mesmo
+void bindSceneMeshBuffers(const SceneMeshes& meshes) {
+    glBindBuffer(GL_ARRAY_BUFFER, meshes.vertices.buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshes.indices.buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)meshes.vertices.offset); glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(meshes.vertices.offset + 3 * sizeof(float))); glEnableVertexAttribArray(1);
+}
+
+SceneMeshes createSceneMeshes() {
+    MeshData data;
+    SceneMeshes meshes;
+    meshes.ranges[MESH_CUBE] = appendCubeMesh(data);
+    meshes.ranges[MESH_SPHERE] = appendSphereMesh(data, 1.0f, 32, 16);
+    meshes.ranges[MESH_CYLINDER] = appendCylinderMesh(data, 1.0f, 1.0f, 24);
+    meshes.vertices = suballocate(g_staticGeometry, data.vertices.size() * sizeof(float), 16, data.vertices.data());
+    meshes.indices = suballocate(g_staticGeometry, data.indices.size() * sizeof(unsigned int), 16, data.indices.data());
+    // baseVertex continua relativo ao início dos vértices (o offset vai no glVertexAttribPointer); os índices andam a faixa
+    for (MeshRange& range : meshes.ranges) range.firstIndex += (int)(meshes.indices.offset / sizeof(unsigned int));
+    meshes.vao = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_GEOMETRY, "VAO da cena");
+    glBindVertexArray(meshes.vao);
+    bindSceneMeshBuffers(meshes);
+    glBindVertexArray(0);
+    return meshes;
+}
+
+void destroySceneMeshes(SceneMeshes& meshes) {
+    meshes.vao.reset();
+}
+
+// --- SNAPSHOT DO JOGO ---
+// Tudo que buildScene e as luzes leem do estado da partida. Guardamos um por frame para o replay;
+// é também o que a simulação entrega ao render no pipeline.
+struct GameSnapshot {
+    GameState gameState; KeeperState keeperState; Team currentKicker; int currentKick;
+    int team1Results[3]; int team2Results[3];
+    glm::vec3 playerPosition, ballPosition, keeperPosition, keeperTargetPos;
+    float netAnimationTimer, animationTimer, matchTime;
+};
+
+GameSnapshot captureSnapshot() {
+    GameSnapshot s;
+    s.gameState = g_gameState; s.keeperState = g_keeperState; s.currentKicker = g_currentKicker; s.currentKick = g_currentKick;
+    for (int i = 0; i < 3; ++i) { s.team1Results[i] = g_team1Results[i]; s.team2Results[i] = g_team2Results[i]; }
+    s.playerPosition = g_playerPosition; s.ballPosition = g_ballPosition; s.keeperPosition = g_keeperPosition; s.keeperTargetPos = g_keeperTargetPos;
+    s.netAnimationTimer = g_netAnimationTimer; s.animationTimer = g_animationTimer; s.matchTime = g_matchTime;
+    return s;
+}
+
+void applySnapshot(const GameSnapshot& s) {
+    g_gameState = s.gameState; g_keeperState = s.keeperState; g_currentKicker = s.currentKicker; g_currentKick = s.currentKick;
+    for (int i = 0; i < 3; ++i) { g_team1Results[i] = s.team1Results[i]; g_team2Results[i] = s.team2Results[i]; }
+    g_playerPosition = s.playerPosition; g_ballPosition = s.ballPosition; g_keeperPosition = s.keeperPosition; g_keeperTargetPos = s.keeperTargetPos;
+    g_netAnimationTimer = s.netAnimationTimer; g_animationTimer = s.animationTimer; g_matchTime = s.matchTime;
+}
+
+// Histórico para o replay em picture-in-picture (~3 s a 60 fps)
+const int REPLAY_FRAMES = 180;
+GameSnapshot g_replayRing[REPLAY_FRAMES];
+int g_replayHead = 0, g_replayCount = 0;
+
+void recordReplaySnapshot() {
+    g_replayRing[g_replayHead] = captureSnapshot();
+    g_replayHead = (g_replayHead + 1) % REPLAY_FRAMES;
+    g_replayCount = std::min(g_replayCount + 1, REPLAY_FRAMES);
+}
+
+// Snapshot mais antigo guardado: o replay mostra a jogada com ~3 s de atraso
+const GameSnapshot& replaySnapshot() {
+    return g_replayRing[(g_replayHead - g_replayCount + REPLAY_FRAMES) % REPLAY_FRAMES];
+}
+
+
+// --- CÂMERAS ---
+struct CameraView {
+    const char* name;
+    float x, y, width, height; // Viewport em fração da janela (origem embaixo à esquerda)
+    glm::vec3 position, target;
+    float fovDegrees;
+    bool replay;               // Mostra a cena atrasada (replaySnapshot) em vez da atual
+    glm::mat4 view, projection;
+};
+const int MAX_VIEWS = 5;
+
+CameraView makeView(const char* name, float x, float y, float width, float height, glm::vec3 position, glm::vec3 target, float fovDegrees, bool replay = false) {
+    CameraView v;
+    v.name = name; v.x = x; v.y = y; v.width = width; v.height = height;
+    v.position = position; v.target = target; v.fovDegrees = fovDegrees; v.replay = replay;
+    v.view = glm::lookAt(position, target, glm::vec3(0.0f, 1.0f, 0.0f));
+    v.projection = glm::perspective(glm::radians(fovDegrees), (width * WIDTH) / (height * HEIGHT), 0.1f, 100.0f);
+    return v;
+}
+
+int setupViews(CameraView* views) {
+    int count = 0;
+    // Câmera orbital principal (tela inteira)
+    views[count++] = makeView("orbita", 0.0f, 0.0f, 1.0f, 1.0f, g_cameraPos, g_cameraTarget, 45.0f);
+    if (!g_multiView) return count;
+
+    glm::vec3 goalCenter(0.0f, 1.0f, g_goalLineZ);
+    // Atrás do batedor, olhando para o gol
+    glm::vec3 toGoal = glm::normalize(goalCenter - g_playerPosition);
+    views[count++] = makeView("batedor", 0.0f, 0.0f, 0.25f, 0.25f, g_playerPosition - toGoal * 3.0f + glm::vec3(0.0f, 1.0f, 0.0f), goalCenter, 50.0f);
+    // Atrás da rede, acompanhando a bola
+    views[count++] = makeView("goleiro", 0.25f, 0.0f, 0.25f, 0.25f, glm::vec3(0.0f, 1.6f, g_backNetZ - 0.8f), g_ballPosition, 60.0f);
+    // Tática, bem do alto
+    views[count++] = makeView("tatica", 0.5f, 0.0f, 0.25f, 0.25f, glm::vec3(0.0f, 28.0f, 4.0f), glm::vec3(0.0f, 0.0f, -2.0f), 50.0f);
+    // Replay em picture-in-picture (lateral, ~3 s atrasado)
+    views[count++] = makeView("replay", 0.68f, 0.68f, 0.3f, 0.3f, glm::vec3(14.0f, 6.0f, 0.0f), glm::vec3(0.0f, 1.0f, -4.0f), 45.0f, true);
+    return count;
+}
+
+// Planos do frustum (Gribb/Hartmann) a partir de projection * view
+struct Frustum { glm::vec4 planes[6]; };
+
+Frustum frustumFromMatrix(const glm::mat4& m) {
+    Frustum f;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    f.planes[0] = row3 + row0; f.planes[1] = row3 - row0;
+    f.planes[2] = row3 + row1; f.planes[3] = row3 - row1;
+    f.planes[4] = row3 + row2; f.planes[5] = row3 - row2;
+    for (int i = 0; i < 6; ++i) f.planes[i] = f.planes[i] / glm::length(glm::vec3(f.planes[i]));
+    return f;
+}
+
+bool sphereInFrustum(const Frustum& f, const glm::vec4& sphere) {
+    for (int i = 0; i < 6; ++i) {
+        const glm::vec4& p = f.planes[i];
+        if (p.x * sphere.x + p.y * sphere.y + p.z * sphere.z + p.w < -sphere.w) return false;
+    }
+    return true;
+}
+
+
+// --- ILUMINAÇÃO EM CLUSTERS ---
+// Refletores do estádio, emissores do placar e luzes extras (--bench) são distribuídos por câmera num grid
+// 3D de clusters no espaço de visão (tiles na tela x fatias logarítmicas de profundidade). A atribuição roda
+// no CPU, com as fatias divididas entre as threads do pool; o fragment shader só percorre as luzes do seu cluster.
+const int CLUSTER_X = 16, CLUSTER_Y = 9, CLUSTER_Z = 24;
+const int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const int MAX_LIGHTS = 1024;
+const int MAX_LIGHTS_PER_CLUSTER = 128; // Excedentes são descartados (FrameStats.lightsDropped, HUD e --bench)
+const float CLUSTER_NEAR = 0.1f, CLUSTER_FAR = 100.0f; // Mesmos planos da projeção das câmeras
+
+struct PointLight {
+    glm::vec3 position; float radius; // Alcance: a contribuição vai a zero suavemente em radius
+    glm::vec3 color; float intensity;
+};
+
+struct LightClusters {
+    std::vector<PointLight> lights;
+    std::vector<glm::vec4> viewLights;       // Posição no espaço de visão + raio, por câmera
+    std::vector<uint16_t> clusterLights;     // MAX_LIGHTS_PER_CLUSTER por cluster, preenchido pelas threads
+    std::vector<uint16_t> clusterCounts;
+    std::vector<uint16_t> clusterDropped;    // Luzes que tocavam o cluster mas não couberam na lista
+    std::vector<uint32_t> grid;              // (offset, quantidade) por cluster, enviado à GPU
+    std::vector<uint16_t> indices;           // Listas compactadas
+    GpuResource lightBuffer, lightTexture;
+    GpuResource gridBuffer, gridTexture;
+    GpuResource indexBuffer, indexTexture;
+};
+LightClusters g_clusters;
+
+// Unidades de textura da cena (0 e 1 ficam para as texturas dos passes de tela cheia)
+const int LIGHT_DATA_UNIT = 2, CLUSTER_GRID_UNIT = 3, LIGHT_INDEX_UNIT = 4, ALBEDO_UNIT = 5;
+
+GpuResource createBufferTexture(GpuResource& buffer, GLenum internalFormat, GpuCategory category, const char* label) {
+    buffer = GpuResource(GPU_BUFFER, category, label);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+    buffer.setBytes(16);
+    GpuResource texture(GPU_TEXTURE, category, label); // Só a vista do buffer: os bytes contam no buffer
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return texture;
+}
+
+void createLightClusters() {
+    g_clusters.lights.reserve(MAX_LIGHTS);
+    g_clusters.viewLights.resize(MAX_LIGHTS);
+    g_clusters.clusterLights.resize(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+    g_clusters.clusterCounts.resize(CLUSTER_COUNT);
+    g_clusters.clusterDropped.resize(CLUSTER_COUNT);
+    g_clusters.grid.resize(CLUSTER_COUNT * 2);
+    g_clusters.indices.resize(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+    g_clusters.lightTexture = createBufferTexture(g_clusters.lightBuffer, GL_RGBA32F, GPU_CAT_FRAME_DATA, "luzes");
+    g_clusters.gridTexture = createBufferTexture(g_clusters.gridBuffer, GL_RG32UI, GPU_CAT_FRAME_DATA, "grid de clusters");
+    g_clusters.indexTexture = createBufferTexture(g_clusters.indexBuffer, GL_R16UI, GPU_CAT_FRAME_DATA, "indices de luzes");
+}
+
+void destroyLightClusters() {
+    g_clusters.lightTexture.reset();
+    g_clusters.gridTexture.reset();
+    g_clusters.indexTexture.reset();
+    g_clusters.lightBuffer.reset();
+    g_clusters.gridBuffer.reset();
+    g_clusters.indexBuffer.reset();
+}
+
+// Uma vez por programa que usa lightingFragmentCommon
+void bindSceneSamplers(unsigned int program) {
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "albedoMap"), ALBEDO_UNIT);
+    glUniform1i(glGetUniformLocation(program, "lightData"), LIGHT_DATA_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterGrid"), CLUSTER_GRID_UNIT);
+    glUniform1i(glGetUniformLocation(program, "lightIndices"), LIGHT_INDEX_UNIT);
+    glUseProgram(0);
+}
+
+void uploadBuffer(const GpuResource& buffer, const void* data, size_t size) {
+    bindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(size, 16), NULL, GL_STREAM_DRAW); // Orphan: não espera a GPU
+    buffer.setBytes(std::max<size_t>(size, 16));
+    if (size > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+}
+
+// Monta as luzes do frame (espaço do mundo) e envia para a GPU
+void updateLights() {
+    std::vector<PointLight>& lights = g_clusters.lights;
+    lights.clear();
+
+    // Refletores: quatro torres nos cantos do estádio, quatro lâmpadas cada
+    for (int tower = 0; tower < 4; ++tower) {
+        float towerX = (tower % 2 == 0) ? -13.0f : 13.0f;
+        float towerZ = (tower < 2) ? -14.0f : 14.0f;
+        for (int lamp = 0; lamp < 4; ++lamp) {
+            PointLight light;
+            light.position = glm::vec3(towerX + (lamp - 1.5f) * 1.2f, 14.0f, towerZ);
+            light.radius = 40.0f;
+            light.color = glm::vec3(1.0f, 0.97f, 0.9f);
+            light.intensity = 0.06f;
+            lights.push_back(light);
+        }
+    }
+
+    // Placar: cada resultado ilumina a parede atrás dele com a própria cor
+    glm::vec3 scorePos(3.5f, 3.5f, -10.0f);
+    for (int row = 0; row < 2; ++row) {
+        for (int i = 0; i < 3; ++i) {
+            int result = (row == 0) ? g_team1Results[i] : g_team2Results[i];
+            if (result == 0) continue;
+            PointLight light;
+            light.position = scorePos + glm::vec3(i * 0.5f, -row * 0.5f, 0.4f);
+            light.radius = 2.5f;
+            light.color = (result == 1) ? glm::vec3(0.1f, 1.0f, 0.1f) : glm::vec3(1.0f, 0.1f, 0.1f);
+            light.intensity = 0.8f;
+            lights.push_back(light);
+        }
+    }
+
+    // Sinalizadores espalhados pela torcida e pelo gramado (stress de luzes)
+    for (int i = 0; i < g_extraLights && (int)lights.size() < MAX_LIGHTS; ++i) {
+        float angle = i * 2.399963f + g_matchTime * 0.3f; // Ângulo áureo: distribuição uniforme
+        float distance = 4.0f + 12.0f * std::sqrt((i + 0.5f) / (g_extraLights + 0.5f));
+        PointLight light;
+        light.position = glm::vec3(std::cos(angle) * distance, 0.8f + (i % 5) * 0.6f, std::sin(angle) * distance);
+        light.radius = 3.0f + (i % 3);
+        light.color = glm::vec3(0.5f + 0.5f * std::sin(i * 1.7f), 0.5f + 0.5f * std::sin(i * 2.3f + 2.0f), 0.5f + 0.5f * std::sin(i * 3.1f + 4.0f));
+        light.intensity = 0.6f;
+        lights.push_back(light);
+    }
+
+    uploadBuffer(g_clusters.lightBuffer, lights.data(), lights.size() * sizeof(PointLight));
+    g_frameStats.lights = (int)lights.size();
+}
+
+// Distribui as luzes pelos clusters da câmera e envia grid + índices
+void assignLights(const CameraView& view) {
+    LightClusters& c = g_clusters;
+    int lightCount = (int)c.lights.size();
+    for (int i = 0; i < lightCount; ++i) {
+        glm::vec4 p = view.view * glm::vec4(c.lights[i].position, 1.0f);
+        c.viewLights[i] = glm::vec4(p.x, p.y, p.z, c.lights[i].radius);
+    }
+
+    float invProjX = 1.0f / view.projection[0][0], invProjY = 1.0f / view.projection[1][1];
+    float depthRatio = CLUSTER_FAR / CLUSTER_NEAR;
+    auto assignSlices = [&](int firstSlice, int endSlice) {
+        uint16_t candidates[MAX_LIGHTS];
+        for (int z = firstSlice; z < endSlice; ++z) {
+            float sliceNear = CLUSTER_NEAR * std::pow(depthRatio, (float)z / CLUSTER_Z);
+            float sliceFar = CLUSTER_NEAR * std::pow(depthRatio, (float)(z + 1) / CLUSTER_Z);
+            // Só as luzes que cruzam esta fatia de profundidade
+            int candidateCount = 0;
+            for (int i = 0; i < lightCount; ++i) {
+                float depth = -c.viewLights[i].z, radius = c.viewLights[i].w;
+                if (depth + radius >= sliceNear && depth - radius <= sliceFar) candidates[candidateCount++] = (uint16_t)i;
             }
-            if (g_gameState == STATE_RESETTING) {
-                if(g_resetTimer > 0.0f) { g_resetTimer -= deltaTime; }
-                if (g_resetTimer <= 0.0f) {
-                    if (g_currentKick == 6) {
-                        g_gameState = STATE_GAMEOVER; printFinalScore(); glfwSetWindowShouldClose(window, true); 
-                    } else {
-                        g_gameState = STATE_READY; g_keeperState = KEEPER_IDLE; g_animationTimer = 0.0f;
-                        g_currentKicker = (g_currentKicker == TEAM_1) ? TEAM_2 : TEAM_1; 
-                        g_playerPosition = g_playerStartPos;
-                        g_ballPosition = glm::vec3(0.0f, 0.1f, 6.0f); 
-                        g_keeperPosition = glm::vec3(0.0f, 0.8f, -10.0f); 
-                        g_goalRecorded = false; 
-                        printKickMessage();
+            for (int y = 0; y < CLUSTER_Y; ++y) {
+                float ndcY0 = -1.0f + 2.0f * y / CLUSTER_Y, ndcY1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+                for (int x = 0; x < CLUSTER_X; ++x) {
+                    float ndcX0 = -1.0f + 2.0f * x / CLUSTER_X, ndcX1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+                    // AABB do cluster no espaço de visão (cantos do tile nas duas profundidades)
+                    float xs[4] = { ndcX0 * sliceNear * invProjX, ndcX1 * sliceNear * invProjX, ndcX0 * sliceFar * invProjX, ndcX1 * sliceFar * invProjX };
+                    float ys[4] = { ndcY0 * sliceNear * invProjY, ndcY1 * sliceNear * invProjY, ndcY0 * sliceFar * invProjY, ndcY1 * sliceFar * invProjY };
+                    glm::vec3 boxMin(std::min(std::min(xs[0], xs[1]), std::min(xs[2], xs[3])), std::min(std::min(ys[0], ys[1]), std::min(ys[2], ys[3])), -sliceFar);
+                    glm::vec3 boxMax(std::max(std::max(xs[0], xs[1]), std::max(xs[2], xs[3])), std::max(std::max(ys[0], ys[1]), std::max(ys[2], ys[3])), -sliceNear);
+
+                    int cluster = x + CLUSTER_X * (y + CLUSTER_Y * z);
+                    uint16_t* out = &c.clusterLights[cluster * MAX_LIGHTS_PER_CLUSTER];
+                    int count = 0, dropped = 0;
+                    for (int k = 0; k < candidateCount; ++k) {
+                        const glm::vec4& light = c.viewLights[candidates[k]];
+                        glm::vec3 closest = glm::clamp(glm::vec3(light), boxMin, boxMax);
+                        glm::vec3 delta = closest - glm::vec3(light);
+                        if (glm::dot(delta, delta) <= light.w * light.w) {
+                            if (count < MAX_LIGHTS_PER_CLUSTER) out[count++] = candidates[k];
+                            else dropped++; // Lista cheia: fica de fora (os refletores vêm primeiro e nunca caem)
+                        }
                     }
+                    c.clusterCounts[cluster] = (uint16_t)count;
+                    c.clusterDropped[cluster] = (uint16_t)dropped;
                 }
             }
-        } // Fim do if(STATE_GAMEOVER)
-
-        // --- LÓGICA DE DESENHO (RENDER) ---
-        glClearColor(0.1f, 0.2f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shaderProgram);
-
-        // 1. Processa os inputs de teclado
-        processInput(window);
-
-        // 2. Atualiza a posição da câmera e a view matrix
-        updateCamera(); 
-
-        // 3. Envia as matrizes e posições atualizadas para o Shader
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(g_viewMatrix)); // Usa a g_viewMatrix
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(g_lightPos));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(g_cameraPos)); // Usa a g_cameraPos
-        // --- Fim do Bloco de Câmera ---
-
-        // --- Desenha Objetos OPACOS ---
-        glBindVertexArray(cubeVAO);
-        drawField(shaderProgram, cubeVAO);
-        drawFieldMarkings(shaderProgram, cubeVAO);
-        drawScoreboard(shaderProgram, cubeVAO);
-
-        // glBindVertexArray(cubeVAO);
-        // drawField(shaderProgram, cubeVAO);
-        // drawFieldMarkings(shaderProgram, cubeVAO);
-        // drawScoreboard(shaderProgram, cubeVAO);
-        
-        drawGrandstands(shaderProgram, cubeVAO); // 
+        }
+    };
+    g_threadPool.parallelFor(CLUSTER_Z, 2, assignSlices);
 
-        drawCrowd(shaderProgram, cubeVAO, sphereVAO, sphereIndexCount);
-        
-        // Goleiro 
-        drawKeeper(shaderProgram, cubeVAO, sphereVAO, sphereIndexCount, g_keeperPosition, g_keeperColor);
-        
-        // Desenha o jogador ATIVO (com animação de corrida/chute)
-        if (g_gameState != STATE_GAMEOVER) {
-            drawPlayer(shaderProgram, cubeVAO, sphereVAO, sphereIndexCount, g_playerPosition, g_currentKicker);
+    // Compacta as listas (prefix sum) na thread principal
+    uint32_t offset = 0;
+    int dropped = 0, truncated = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        uint32_t count = c.clusterCounts[cluster];
+        dropped += c.clusterDropped[cluster];
+        if (c.clusterDropped[cluster] > 0) truncated++;
+        c.grid[cluster * 2] = offset;
+        c.grid[cluster * 2 + 1] = count;
+        std::copy_n(&c.clusterLights[cluster * MAX_LIGHTS_PER_CLUSTER], count, &c.indices[offset]);
+        offset += count;
+    }
+    uploadBuffer(c.gridBuffer, c.grid.data(), c.grid.size() * sizeof(uint32_t));
+    uploadBuffer(c.indexBuffer, c.indices.data(), offset * sizeof(uint16_t));
+    g_frameStats.lightRefs += (int)offset;
+    g_frameStats.lightsDropped += dropped;
+    g_frameStats.truncatedClusters += truncated;
+
+    bindTexture(LIGHT_DATA_UNIT, GL_TEXTURE_BUFFER, c.lightTexture);
+    bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, c.gridTexture);
+    bindTexture(LIGHT_INDEX_UNIT, GL_TEXTURE_BUFFER, c.indexTexture);
+}
+
+
+// --- TEXTURAS (streaming) ---
+// Grama, arquibancadas e uniformes. Decodificação (stb_image, de texturas/) ou geração procedural e a cadeia
+// de mipmaps rodam em threads de fundo; a thread principal só envia os níveis prontos via PBO, do menor para o
+// maior, respeitando um orçamento de bytes por frame. Enquanto nenhum nível está na GPU, usa-se o placeholder.
+enum TextureState { TEX_QUEUED, TEX_DECODING, TEX_DECODED, TEX_UPLOADING, TEX_RESIDENT };
+const int MAX_MIP_LEVELS = 16;
+
+struct MaterialInfo {
+    const char* name;
+    const char* file;     // Em texturas/; sem o arquivo, a textura é gerada
+    int generatedSize;
+    float textureScale;   // Repetições por unidade (mundo ou modelo)
+    int textureMode;      // 0 = sem textura, 1 = triplanar no mundo, 2 = triplanar no espaço do modelo
+};
+const MaterialInfo g_materialInfo[MAT_COUNT] = {
+    {"nenhum",    nullptr,                 0,    1.0f, 0},
+    {"grama",     "texturas/grama.png",    1024, 0.2f, 1},
+    {"concreto",  "texturas/concreto.png", 512,  0.5f, 1},
+    {"uniforme1", "texturas/uniforme1.png", 256, 2.0f, 2},
+    {"uniforme2", "texturas/uniforme2.png", 256, 2.0f, 2},
+};
+
+struct StreamedTexture {
+    std::atomic<int> state{TEX_QUEUED};
+    std::vector<unsigned char> pixels; // RGBA8, todos os níveis em sequência (liberado depois do upload)
+    int levelCount = 0;
+    int levelWidth[MAX_MIP_LEVELS], levelHeight[MAX_MIP_LEVELS];
+    size_t levelOffset[MAX_MIP_LEVELS];
+    bool fromFile = false;
+    // Só a thread principal mexe daqui para baixo
+    GpuResource glTexture;
+    int uploadLevel = -1, uploadRow = 0; // Nível/linha sendo enviados (do menor nível para o 0)
+    int residentLevels = 0;
+    size_t gpuBytes = 0;
+};
+
+struct TextureStreamer {
+    StreamedTexture textures[MAT_COUNT];
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    int jobs[MAT_COUNT]; int jobCount = 0; // Protegidos por mutex
+    std::atomic<int> inFlight{0};          // Jobs retirados da fila e ainda não entregues em decoded
+    bool quit = false;
+    MpscQueue<int, 64> decoded;            // Workers -> thread principal
+    int uploadQueue[MAT_COUNT]; int uploadCount = 0;
+    GpuResource pbo;
+    size_t uploadBudget = 1024 * 1024;     // Bytes por frame (--upload-budget KB)
+    GpuResource placeholder;
+    int generatedSizeScale = 1;            // Benchmark: texturas geradas maiores
+    // Estatísticas
+    size_t uploadedThisFrame = 0, maxUploadPerFrame = 0, totalUploaded = 0;
+};
+TextureStreamer g_textures;
+
+float hashNoise(int x, int y, int seed) {
+    unsigned int h = (unsigned int)x * 374761393u + (unsigned int)y * 668265263u + (unsigned int)seed * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return ((h ^ (h >> 16)) & 0xffff) / 65535.0f;
+}
+
+// Texturas de detalhe em torno de 1.0 (multiplicam objectColor), geradas quando não há arquivo
+void generateTexture(int material, int size, std::vector<unsigned char>& out) {
+    out.resize((size_t)size * size * 4);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            float n = hashNoise(x, y, material), value = 1.0f;
+            glm::vec3 tint(1.0f);
+            if (material == MAT_GRASS) {
+                bool stripe = ((x * 2) / size) % 2 == 0; // Faixas de corte, duas por repetição
+                value = (stripe ? 1.05f : 0.85f) * (0.85f + 0.3f * n * hashNoise(x / 2, y / 7, 7));
+                tint = glm::vec3(0.9f, 1.0f, 0.85f);
+            } else if (material == MAT_CONCRETE) {
+                value = 0.8f + 0.25f * (0.6f * n + 0.4f * hashNoise(x / 8, y / 8, 3));
+            } else {
+                // Trama do tecido: fios alternados em x e y
+                bool warp = ((x / 2) + (y / 8)) % 2 == 0, weft = ((y / 2) + (x / 8)) % 2 == 0;
+                value = 0.85f + (warp ? 0.1f : 0.0f) + (weft ? 0.08f : 0.0f) + 0.05f * n;
+            }
+            for (int c = 0; c < 3; ++c) out[((size_t)y * size + x) * 4 + c] = (unsigned char)glm::clamp(value * tint[c] * 200.0f, 0.0f, 255.0f);
+            out[((size_t)y * size + x) * 4 + 3] = 255;
         }
+    }
+}
+
+// Cadeia de mipmaps com filtro caixa 2x2; o nível 0 já está em pixels
+void buildMipChain(StreamedTexture& texture, int width, int height) {
+    size_t total = 0;
+    int levels = 0;
+    for (int w = width, h = height; levels < MAX_MIP_LEVELS; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+        texture.levelWidth[levels] = w; texture.levelHeight[levels] = h; texture.levelOffset[levels] = total;
+        total += (size_t)w * h * 4;
+        levels++;
+        if (w == 1 && h == 1) break;
+    }
+    texture.levelCount = levels;
+    texture.pixels.resize(total);
+    for (int level = 1; level < levels; ++level) {
+        const unsigned char* src = &texture.pixels[texture.levelOffset[level - 1]];
+        unsigned char* dst = &texture.pixels[texture.levelOffset[level]];
+        int srcW = texture.levelWidth[level - 1], srcH = texture.levelHeight[level - 1];
+        int dstW = texture.levelWidth[level], dstH = texture.levelHeight[level];
+        for (int y = 0; y < dstH; ++y) {
+            int y0 = std::min(y * 2, srcH - 1), y1 = std::min(y * 2 + 1, srcH - 1);
+            for (int x = 0; x < dstW; ++x) {
+                int x0 = std::min(x * 2, srcW - 1), x1 = std::min(x * 2 + 1, srcW - 1);
+                for (int c = 0; c < 4; ++c) {
+                    int sum = src[(y0 * srcW + x0) * 4 + c] + src[(y0 * srcW + x1) * 4 + c] + src[(y1 * srcW + x0) * 4 + c] + src[(y1 * srcW + x1) * 4 + c];
+                    dst[(y * dstW + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+void decodeTexture(int material) {
+    StreamedTexture& texture = g_textures.textures[material];
+    const MaterialInfo& info = g_materialInfo[material];
+    int width = 0, height = 0, channels = 0;
+    unsigned char* image = info.file ? stbi_load(info.file, &width, &height, &channels, 4) : nullptr;
+    if (image) {
+        texture.pixels.assign(image, image + (size_t)width * height * 4);
+        stbi_image_free(image);
+        texture.fromFile = true;
+    } else {
+        width = height = info.generatedSize * g_textures.generatedSizeScale;
+        generateTexture(material, width, texture.pixels);
+        texture.fromFile = false;
+    }
+    buildMipChain(texture, width, height);
+    texture.state.store(TEX_DECODED);
+    while (!g_textures.decoded.push(material)) std::this_thread::yield();
+    g_textures.inFlight.fetch_sub(1);
+}
 
-        // Bola (Esfera)
-        drawSphere(shaderProgram, sphereVAO, sphereIndexCount, glm::scale(glm::translate(glm::mat4(1.0f), g_ballPosition), glm::vec3(g_ballRadius)), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+void textureWorkerThread() {
+    for (;;) {
+        int material;
+        {
+            std::unique_lock<std::mutex> lock(g_textures.mutex);
+            g_textures.wake.wait(lock, [] { return g_textures.quit || g_textures.jobCount > 0; });
+            if (g_textures.quit) return;
+            material = g_textures.jobs[--g_textures.jobCount];
+            g_textures.inFlight.fetch_add(1);
+            g_textures.textures[material].state.store(TEX_DECODING);
+        }
+        decodeTexture(material);
+    }
+}
 
-        // --- Desenha Objetos TRANSPARENTES (Rede) por último ---
-        // Usa cylinderVAO para traves
-        drawGoal(shaderProgram, cubeVAO, cylinderVAO, cylinderIndexCount);
+void queueTextureLoads() {
+    {
+        std::lock_guard<std::mutex> lock(g_textures.mutex);
+        for (int material = MAT_COUNT - 1; material > MAT_NONE; --material) {
+            g_textures.textures[material].state.store(TEX_QUEUED);
+            g_textures.jobs[g_textures.jobCount++] = material;
+        }
+    }
+    g_textures.wake.notify_all();
+}
 
-        glfwSwapBuffers(window);
+void startTextureStreaming(int workerCount) {
+    // Placeholder: xadrez claro 8x8, visível mas neutro sob objectColor
+    unsigned char checker[8 * 8 * 4];
+    for (int i = 0; i < 64; ++i) {
+        unsigned char v = (((i % 8) / 2 + (i / 16)) % 2 == 0) ? 255 : 200;
+        checker[i * 4] = checker[i * 4 + 1] = checker[i * 4 + 2] = v; checker[i * 4 + 3] = 255;
     }
-    // --- LIMPEZA ---
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &sphereVAO);
-    glDeleteVertexArrays(1, &cylinderVAO);
-    glDeleteProgram(shaderProgram);
-    glfwTerminate();
-    return 0;
-}
\ No newline at end of file
+    g_textures.placeholder = GpuResource(GPU_TEXTURE, GPU_CAT_TEXTURES, "textura provisoria");
+    bindTextureForUpdate(g_textures.placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+    g_textures.placeholder.setBytes(sizeof(checker));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    g_textures.pbo = GpuResource(GPU_BUFFER, GPU_CAT_TEXTURES, "PBO de upload");
+
+    for (int i = 0; i < workerCount; ++i) g_textures.workers.emplace_back(textureWorkerThread);
+    queueTextureLoads();
+}
+
+void releaseTexture(StreamedTexture& texture) {
+    texture.glTexture.reset(); // Apagada só quando os frames que ainda a amostram terminarem
+    texture.residentLevels = 0; texture.gpuBytes = 0; texture.uploadLevel = -1;
+    std::vector<unsigned char>().swap(texture.pixels);
+}
+
+// Benchmark: descarta tudo e recarrega com texturas geradas sizeScale vezes maiores
+void restartTextureStreaming(int sizeScale) {
+    // Espera os workers terminarem o que estiver em andamento
+    for (;;) {
+        bool busy = false;
+        { std::lock_guard<std::mutex> lock(g_textures.mutex); busy = g_textures.jobCount > 0 || g_textures.inFlight.load() > 0; }
+        if (!busy) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    int material;
+    while (g_textures.decoded.pop(material)) {}
+    g_textures.uploadCount = 0;
+    for (int m = MAT_NONE + 1; m < MAT_COUNT; ++m) releaseTexture(g_textures.textures[m]);
+    g_textures.generatedSizeScale = sizeScale;
+    g_textures.maxUploadPerFrame = 0;
+    queueTextureLoads();
+}
+
+void stopTextureStreaming() {
+    { std::lock_guard<std::mutex> lock(g_textures.mutex); g_textures.quit = true; }
+    g_textures.wake.notify_all();
+    for (std::thread& worker : g_textures.workers) worker.join();
+    for (StreamedTexture& texture : g_textures.textures) releaseTexture(texture);
+    g_textures.placeholder.reset();
+    g_textures.pbo.reset();
+}
+
+// Texturas decodificadas ganham armazenamento na GPU e entram na fila de upload
+void beginTextureUpload(int material) {
+    StreamedTexture& texture = g_textures.textures[material];
+    texture.glTexture = GpuResource(GPU_TEXTURE, GPU_CAT_TEXTURES, g_materialInfo[material].name);
+    bindTextureForUpdate(texture.glTexture);
+    size_t bytes = 0;
+    for (int level = 0; level < texture.levelCount; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, texture.levelWidth[level], texture.levelHeight[level], 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        bytes += (size_t)texture.levelWidth[level] * texture.levelHeight[level] * 4;
+    }
+    texture.glTexture.setBytes(bytes);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    texture.uploadLevel = texture.levelCount - 1;
+    texture.uploadRow = 0;
+    texture.state.store(TEX_UPLOADING);
+    g_textures.uploadQueue[g_textures.uploadCount++] = material;
+}
+
+// Uma vez por frame, na thread principal: envia faixas de linhas até gastar o orçamento
+void pumpTextureStreaming() {
+    int material;
+    while (g_textures.decoded.pop(material)) beginTextureUpload(material);
+
+    size_t budget = g_textures.uploadBudget;
+    g_textures.uploadedThisFrame = 0;
+    while (g_textures.uploadCount > 0) {
+        StreamedTexture& texture = g_textures.textures[g_textures.uploadQueue[0]];
+        int level = texture.uploadLevel;
+        int width = texture.levelWidth[level], height = texture.levelHeight[level];
+        size_t rowBytes = (size_t)width * 4;
+        // Pelo menos uma linha por frame, mesmo que passe do orçamento
+        int rows = std::min(height - texture.uploadRow, (int)std::max<size_t>(1, budget / rowBytes));
+        if (g_textures.uploadedThisFrame > 0 && (size_t)rows * rowBytes > budget) break;
+        size_t bytes = (size_t)rows * rowBytes;
+
+        bindBuffer(GL_PIXEL_UNPACK_BUFFER, g_textures.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW); // Orphan: não espera o upload anterior
+        g_textures.pbo.setBytes(bytes);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            std::memcpy(mapped, &texture.pixels[texture.levelOffset[level] + (size_t)texture.uploadRow * rowBytes], bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        bindTextureForUpdate(texture.glTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, texture.uploadRow, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+        texture.uploadRow += rows;
+        texture.gpuBytes += bytes;
+        g_textures.uploadedThisFrame += bytes;
+        budget -= std::min(budget, bytes);
+
+        if (texture.uploadRow == height) {
+            // Nível completo: passa a ser amostrável (BASE_LEVEL desce um nível)
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            texture.residentLevels++;
+            texture.uploadLevel--;
+            texture.uploadRow = 0;
+            if (texture.uploadLevel < 0) {
+                texture.state.store(TEX_RESIDENT);
+                std::vector<unsigned char>().swap(texture.pixels);
+                g_textures.uploadCount--;
+                for (int i = 0; i < g_textures.uploadCount; ++i) g_textures.uploadQueue[i] = g_textures.uploadQueue[i + 1];
+            }
+        }
+        if (budget == 0) break;
+    }
+    bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // Senão os próximos glTexImage leriam do PBO
+    g_textures.totalUploaded += g_textures.uploadedThisFrame;
+    g_textures.maxUploadPerFrame = std::max(g_textures.maxUploadPerFrame, g_textures.uploadedThisFrame);
+    g_frameStats.textureUploadBytes = (int)g_textures.uploadedThisFrame;
+}
+
+// Textura a usar para o material: a real assim que o menor mip estiver na GPU, senão o placeholder
+unsigned int materialTexture(int material) {
+    const StreamedTexture& texture = g_textures.textures[material];
+    return texture.residentLevels > 0 ? texture.glTexture : g_textures.placeholder;
+}
+
+int residentTextureCount(size_t* gpuBytes) {
+    int resident = 0;
+    size_t bytes = 0;
+    for (int m = MAT_NONE + 1; m < MAT_COUNT; ++m) {
+        resident += g_textures.textures[m].state.load() == TEX_RESIDENT;
+        bytes += g_textures.textures[m].gpuBytes;
+    }
+    if (gpuBytes) *gpuBytes = bytes;
+    return resident;
+}
+
+void printTextureResidency() {
+    static const char* stateNames[] = {"na fila", "decodificando", "decodificada", "enviando", "residente"};
+    std::cout << "--- Texturas ---" << std::endl;
+    size_t totalGpu = 0, totalCpu = 0;
+    for (int m = MAT_NONE + 1; m < MAT_COUNT; ++m) {
+        const StreamedTexture& texture = g_textures.textures[m];
+        int state = texture.state.load();
+        std::cout << "  " << std::left << std::setw(10) << g_materialInfo[m].name << std::right << " " << stateNames[state];
+        if (state >= TEX_UPLOADING) std::cout << ", " << texture.levelWidth[0] << "x" << texture.levelHeight[0] << (texture.fromFile ? " (arquivo)" : " (gerada)")
+                                              << ", mips " << texture.residentLevels << "/" << texture.levelCount;
+        std::cout << ", GPU " << std::fixed << std::setprecision(2) << texture.gpuBytes / (1024.0 * 1024.0) << " MiB" << std::endl;
+        totalGpu += texture.gpuBytes;
+        totalCpu += texture.pixels.capacity();
+    }
+    std::cout << "  Total: GPU " << totalGpu / (1024.0 * 1024.0) << " MiB, staging CPU " << totalCpu / (1024.0 * 1024.0)
+              << " MiB, maior upload num frame " << g_textures.maxUploadPerFrame / 1024.0 << " KiB" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+
+// --- OCLUSÃO (Z hierárquico no CPU) ---
+// Os oclusores grandes (degraus das arquibancadas e o gramado) são rasterizados numa thread própria, em baixa
+// resolução, enquanto a thread principal monta o resto da cena. Cada pixel guarda a profundidade inversa (1/w)
+// do oclusor mais próximo; cada nível da hierarquia guarda o mínimo dos 4 filhos (o oclusor mais distante do bloco).
+// Um objeto cujo ponto mais próximo está atrás desse valor em todos os blocos que cobre é descartado.
+const int OCC_WIDTH = 256, OCC_HEIGHT = 128, OCC_LEVELS = 6; // Nível 5: 8x4 blocos
+const int MAX_OCCLUDERS = 256;
+const float OCC_NEAR = 0.1f;
+
+struct OcclusionBuffer {
+    std::vector<float> levels[OCC_LEVELS]; // levels[0]: OCC_WIDTH x OCC_HEIGHT
+    glm::mat4 view, projection;
+};
+
+struct OcclusionCuller {
+    OcclusionBuffer buffers[MAX_VIEWS];
+    std::vector<Affine3x4> occluders;     // Copiados da lista de desenho: a lista pode crescer enquanto o worker lê
+    int viewCount = 0;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    bool requested = false, quit = false;
+};
+OcclusionCuller g_occlusion;
+
+// Rasteriza um triângulo já em pixels (x, y, 1/w), guardando o máximo de 1/w (o mais próximo)
+void rasterizeOccluderTriangle(float* depth, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (std::fabs(area) < 1e-6f) return;
+    int minX = std::max(0, (int)std::floor(std::min(std::min(v0.x, v1.x), v2.x)));
+    int maxX = std::min(OCC_WIDTH - 1, (int)std::ceil(std::max(std::max(v0.x, v1.x), v2.x)));
+    int minY = std::max(0, (int)std::floor(std::min(std::min(v0.y, v1.y), v2.y)));
+    int maxY = std::min(OCC_HEIGHT - 1, (int)std::ceil(std::max(std::max(v0.y, v1.y), v2.y)));
+    if (minX > maxX || minY > maxY) return;
+    minX &= ~3; // Blocos de 4 pixels alinhados
+
+    // Funções de aresta e plano de profundidade, normalizadas pela área (vale para as duas orientações)
+    float inv = 1.0f / area;
+    float e0a = (v1.y - v2.y) * inv, e0b = (v2.x - v1.x) * inv, e0c = (v1.x * v2.y - v2.x * v1.y) * inv;
+    float e1a = (v2.y - v0.y) * inv, e1b = (v0.x - v2.x) * inv, e1c = (v2.x * v0.y - v0.x * v2.y) * inv;
+    float e2a = (v0.y - v1.y) * inv, e2b = (v1.x - v0.x) * inv, e2c = (v0.x * v1.y - v1.x * v0.y) * inv;
+    float za = e0a * v0.z + e1a * v1.z + e2a * v2.z;
+    float zb = e0b * v0.z + e1b * v1.z + e2b * v2.z;
+    float zc = e0c * v0.z + e1c * v1.z + e2c * v2.z;
+
+    for (int y = minY; y <= maxY; ++y) {
+        float py = y + 0.5f;
+        float* row = depth + y * OCC_WIDTH;
+#ifdef AFFINE_SSE
+        __m128 px = _mm_setr_ps(minX + 0.5f, minX + 1.5f, minX + 2.5f, minX + 3.5f);
+        const __m128 four = _mm_set1_ps(4.0f), zero = _mm_setzero_ps();
+        for (int x = minX; x <= maxX; x += 4, px = _mm_add_ps(px, four)) {
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0a), px), _mm_set1_ps(e0b * py + e0c));
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1a), px), _mm_set1_ps(e1b * py + e1c));
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2a), px), _mm_set1_ps(e2b * py + e2c));
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+            if (_mm_movemask_ps(inside) == 0) continue;
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zb * py + zc));
+            __m128 old = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_max_ps(old, z)), _mm_andnot_ps(inside, old)));
+        }
+#else
+        for (int x = minX; x <= maxX; ++x) {
+            float px = x + 0.5f;
+            if (e0a * px + e0b * py + e0c < 0.0f || e1a * px + e1b * py + e1c < 0.0f || e2a * px + e2b * py + e2c < 0.0f) continue;
+            row[x] = std::max(row[x], za * px + zb * py + zc);
+        }
+#endif
+    }
+}
+
+// Recorta o triângulo (espaço de clip) no plano w = OCC_NEAR e rasteriza o polígono resultante
+void rasterizeOccluderClip(float* depth, const glm::vec4* clip) {
+    glm::vec4 polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& a = clip[i];
+        const glm::vec4& b = clip[(i + 1) % 3];
+        bool aIn = a.w >= OCC_NEAR, bIn = b.w >= OCC_NEAR;
+        if (aIn) polygon[count++] = a;
+        if (aIn != bIn) polygon[count++] = a + (b - a) * ((OCC_NEAR - a.w) / (b.w - a.w));
+    }
+    if (count < 3) return;
+    glm::vec3 screen[4];
+    for (int i = 0; i < count; ++i) {
+        float invW = 1.0f / polygon[i].w;
+        screen[i] = glm::vec3((polygon[i].x * invW * 0.5f + 0.5f) * OCC_WIDTH, (polygon[i].y * invW * 0.5f + 0.5f) * OCC_HEIGHT, invW);
+    }
+    rasterizeOccluderTriangle(depth, screen[0], screen[1], screen[2]);
+    if (count == 4) rasterizeOccluderTriangle(depth, screen[0], screen[2], screen[3]);
+}
+
+void rasterizeOcclusionView(OcclusionBuffer& buffer) {
+    static const int boxTriangles[12][3] = { {0,1,3},{0,3,2}, {4,6,7},{4,7,5}, {0,4,5},{0,5,1}, {2,3,7},{2,7,6}, {0,2,6},{0,6,4}, {1,5,7},{1,7,3} };
+    std::vector<float>& depth = buffer.levels[0];
+    std::fill(depth.begin(), depth.end(), 0.0f); // 1/w = 0: infinitamente longe, não oculta nada
+    glm::mat4 viewProjection = buffer.projection * buffer.view;
+    for (const Affine3x4& model : g_occlusion.occluders) {
+        glm::mat4 mvp = viewProjection * affineToMat4(model);
+        glm::vec4 corners[8];
+        for (int i = 0; i < 8; ++i) corners[i] = mvp * glm::vec4((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f, 1.0f);
+        for (const int* tri : boxTriangles) {
+            glm::vec4 clip[3] = { corners[tri[0]], corners[tri[1]], corners[tri[2]] };
+            rasterizeOccluderClip(depth.data(), clip);
+        }
+    }
+    // Hierarquia: mínimo de 1/w em blocos 2x2 (conservador: o oclusor mais distante do bloco)
+    for (int level = 1; level < OCC_LEVELS; ++level) {
+        int width = OCC_WIDTH >> level, height = OCC_HEIGHT >> level, srcWidth = width * 2;
+        const float* src = buffer.levels[level - 1].data();
+        float* dst = buffer.levels[level].data();
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                dst[y * width + x] = std::min(std::min(src[(2 * y) * srcWidth + 2 * x], src[(2 * y) * srcWidth + 2 * x + 1]),
+                                              std::min(src[(2 * y + 1) * srcWidth + 2 * x], src[(2 * y + 1) * srcWidth + 2 * x + 1]));
+    }
+}
+
+void occlusionThread() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(g_occlusion.mutex);
+            g_occlusion.wake.wait(lock, [] { return g_occlusion.quit || g_occlusion.requested; });
+            if (g_occlusion.quit) return;
+        }
+        for (int i = 0; i < g_occlusion.viewCount; ++i) rasterizeOcclusionView(g_occlusion.buffers[i]);
+        std::lock_guard<std::mutex> lock(g_occlusion.mutex);
+        g_occlusion.requested = false;
+        g_occlusion.finished.notify_one();
+    }
+}
+
+void startOcclusionCuller() {
+    for (OcclusionBuffer& buffer : g_occlusion.buffers)
+        for (int level = 0; level < OCC_LEVELS; ++level) buffer.levels[level].resize((OCC_WIDTH >> level) * (OCC_HEIGHT >> level));
+    g_occlusion.occluders.reserve(MAX_OCCLUDERS);
+    g_occlusion.worker = std::thread(occlusionThread);
+}
+
+void stopOcclusionCuller() {
+    { std::lock_guard<std::mutex> lock(g_occlusion.mutex); g_occlusion.quit = true; }
+    g_occlusion.wake.notify_all();
+    g_occlusion.worker.join();
+}
+
+// Dispara a rasterização dos oclusores já presentes na lista para todas as câmeras
+void beginOcclusion(const CameraView* views, int viewCount, const DrawList& list) {
+    g_occlusion.occluders.clear();
+    for (const DrawItem& item : list)
+        if (item.occluder && item.mesh == MESH_CUBE && g_occlusion.occluders.size() < MAX_OCCLUDERS) g_occlusion.occluders.push_back(item.model);
+    g_occlusion.viewCount = viewCount;
+    for (int i = 0; i < viewCount; ++i) { g_occlusion.buffers[i].view = views[i].view; g_occlusion.buffers[i].projection = views[i].projection; }
+    { std::lock_guard<std::mutex> lock(g_occlusion.mutex); g_occlusion.requested = true; }
+    g_occlusion.wake.notify_one();
+}
+
+void waitOcclusion() {
+    std::unique_lock<std::mutex> lock(g_occlusion.mutex);
+    g_occlusion.finished.wait(lock, [] { return !g_occlusion.requested; });
+}
+
+// true se a esfera envolvente está inteira atrás dos oclusores
+// Tangentes da origem à esfera num eixo (c = coordenada do centro, depth > radius): limites exatos de x/z na tela,
+// tan(θc ∓ α) com tan θc = c / depth e sin α = radius / |(c, depth)|. Também fora do eixo da câmera.
+void sphereScreenExtent(float c, float depth, float radius, float& lo, float& hi) {
+    float t = std::sqrt(std::max(c * c + depth * depth - radius * radius, 0.0f));
+    lo = (c * t - radius * depth) / (depth * t + c * radius);
+    hi = (c * t + radius * depth) / (depth * t - c * radius);
+}
+
+bool sphereOccluded(const OcclusionBuffer& buffer, const glm::vec4& sphere) {
+    glm::vec4 center = buffer.view * glm::vec4(glm::vec3(sphere), 1.0f);
+    float distance = -center.z, radius = sphere.w;
+    float nearest = distance - radius;
+    if (nearest < OCC_NEAR) return false;
+    // Retângulo da projeção exata da esfera (nearest > 0 garante denominadores positivos)
+    float p00 = buffer.projection[0][0], p11 = buffer.projection[1][1];
+    float loX, hiX, loY, hiY;
+    sphereScreenExtent(center.x, distance, radius, loX, hiX);
+    sphereScreenExtent(center.y, distance, radius, loY, hiY);
+    float minX = p00 * loX * 0.5f + 0.5f, maxX = p00 * hiX * 0.5f + 0.5f;
+    float minY = p11 * loY * 0.5f + 0.5f, maxY = p11 * hiY * 0.5f + 0.5f;
+    if (maxX < 0.0f || maxY < 0.0f || minX > 1.0f || minY > 1.0f) return false; // Fora da tela: fica para o frustum
+    minX = std::max(minX, 0.0f); minY = std::max(minY, 0.0f); maxX = std::min(maxX, 1.0f); maxY = std::min(maxY, 1.0f);
+
+    // Nível em que o retângulo cobre no máximo ~4x4 blocos
+    float spanPixels = std::max((maxX - minX) * OCC_WIDTH, (maxY - minY) * OCC_HEIGHT);
+    int level = 0;
+    while (level < OCC_LEVELS - 1 && spanPixels > 4.0f) { spanPixels *= 0.5f; level++; }
+    int width = OCC_WIDTH >> level, height = OCC_HEIGHT >> level;
+    int x0 = std::min((int)(minX * width), width - 1), x1 = std::min((int)(maxX * width), width - 1);
+    int y0 = std::min((int)(minY * height), height - 1), y1 = std::min((int)(maxY * height), height - 1);
+    float objectDepth = 1.0f / nearest;
+    const float* depth = buffer.levels[level].data();
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+            if (depth[y * width + x] <= objectDepth) return false;
+    return true;
+}
+
+
+// --- TRANSPARÊNCIA ---
+// OIT: translúcidos vão para alvos de acumulação/revealage e são resolvidos sobre a cor opaca,
+// sem depender da ordem de desenho. SORTED é o caminho clássico (ordenação por câmera no CPU), mantido para comparação.
+
+struct OitPass {
+    GpuResource sceneFBO, sceneColor, sceneDepth; // Cor opaca + profundidade da cena
+    GpuResource accumFBO, accumTexture, weightTexture; // Compartilha sceneDepth (teste sem escrita)
+    GpuResource oitProgram, compositeProgram;
+    GpuResource emptyVAO;
+};
+OitPass g_oit;
+
+GpuResource createTarget(GLenum internalFormat, GLenum format, GLenum type, size_t bytesPerPixel, const char* label) {
+    GpuResource texture(GPU_TEXTURE, GPU_CAT_RENDER_TARGETS, label);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, WIDTH, HEIGHT, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.setBytes((size_t)WIDTH * HEIGHT * bytesPerPixel);
+    return texture;
+}
+
+void createOitPass() {
+    g_oit.oitProgram = compileProgram({ lightingVertexShader }, { sceneFragmentHeader, lightingFragmentCommon, oitFragmentShader });
+    bindSceneSamplers(g_oit.oitProgram);
+    g_oit.compositeProgram = compileProgram({ fullscreenVertexShader }, { oitCompositeFragmentShader });
+    glUseProgram(g_oit.compositeProgram);
+    glUniform1i(glGetUniformLocation(g_oit.compositeProgram, "accumTexture"), 0);
+    glUniform1i(glGetUniformLocation(g_oit.compositeProgram, "weightTexture"), 1);
+    glUseProgram(0);
+    g_oit.emptyVAO = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_RENDER_TARGETS, "VAO de tela cheia");
+
+    g_oit.sceneColor = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, "cor da cena");
+    g_oit.sceneDepth = GpuResource(GPU_RENDERBUFFER, GPU_CAT_RENDER_TARGETS, "profundidade da cena");
+    glBindRenderbuffer(GL_RENDERBUFFER, g_oit.sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    g_oit.sceneDepth.setBytes((size_t)WIDTH * HEIGHT * 4);
+    g_oit.sceneFBO = GpuResource(GPU_FRAMEBUFFER, GPU_CAT_RENDER_TARGETS, "FBO da cena");
+    glBindFramebuffer(GL_FRAMEBUFFER, g_oit.sceneFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_oit.sceneColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_oit.sceneDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "Framebuffer da cena incompleto" << std::endl;
+
+    g_oit.accumTexture = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, "acumulacao OIT");
+    g_oit.weightTexture = createTarget(GL_R16F, GL_RED, GL_HALF_FLOAT, 2, "revealage OIT");
+    g_oit.accumFBO = GpuResource(GPU_FRAMEBUFFER, GPU_CAT_RENDER_TARGETS, "FBO do OIT");
+    glBindFramebuffer(GL_FRAMEBUFFER, g_oit.accumFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_oit.accumTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, g_oit.weightTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_oit.sceneDepth);
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "Framebuffer do OIT incompleto" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void destroyOitPass() {
+    g_oit.sceneFBO.reset();
+    g_oit.accumFBO.reset();
+    g_oit.sceneColor.reset();
+    g_oit.accumTexture.reset();
+    g_oit.weightTexture.reset();
+    g_oit.sceneDepth.reset();
+    g_oit.emptyVAO.reset();
+    g_oit.oitProgram.reset();
+    g_oit.compositeProgram.reset();
+}
+
+// Cortina de painéis translúcidos entre a marca do pênalti e o gol, em camadas que se sobrepõem na tela
+void drawTranslucentStress() {
+    const int columns = 16, rows = 4;
+    for (int i = 0; i < g_translucentStress; ++i) {
+        int column = i % columns, row = (i / columns) % rows, layer = i / (columns * rows);
+        glm::vec3 position(-7.5f + column * 1.0f, 0.6f + row * 0.9f, g_goalLineZ + 1.0f + (layer % 32) * 0.25f);
+        glm::vec4 color = (i % 2 == 0) ? glm::vec4(g_team1Color2.r, g_team1Color2.g, g_team1Color2.b, 0.25f)
+                                       : glm::vec4(g_team2Color1.r, g_team2Color1.g, g_team2Color1.b, 0.25f);
+        drawCube(affineScale(affineTranslation(position), glm::vec3(0.8f, 0.8f, 0.02f)), color);
+    }
+}
+
+
+// --- RESOLUÇÃO DINÂMICA ---
+// A cena é desenhada num retângulo do framebuffer próprio (scale x tamanho da janela) e ampliada para a janela.
+// Um controlador ajusta scale a cada frame para levar o tempo de GPU da cena até o alvo: média móvel, faixa de
+// histerese em volta do alvo, passo máximo por frame e espera após cada mudança (as queries chegam com atraso).
+struct DynamicResolution {
+    float targetMs = 14.0f;       // --dynres-target
+    float minScale = 0.5f;        // --dynres-min
+    float maxScale = 1.0f;        // --dynres-max
+    float hysteresisPct = 10.0f;  // --dynres-hysteresis: só muda se sair de alvo ± x%
+    float maxStep = 0.05f;        // Variação máxima de scale por ajuste
+    int settleFrames = 4;         // Frames sem ajuste depois de uma mudança
+    float sharpness = 0.2f;       // Nitidez do upscale (0 = só bilinear)
+
+    float scale = 1.0f;
+    int width = WIDTH, height = HEIGHT; // Tamanho de render atual (múltiplo de 8)
+    float gpuMs = 0.0f;                 // Média móvel do tempo de GPU da cena
+    int cooldown = 0;
+    // Timestamps início/fim da cena em anel (não travam o pipeline)
+    static const int QUERY_SLOTS = 4;
+    unsigned int queries[QUERY_SLOTS][2];
+    bool pending[QUERY_SLOTS] = {false};
+    int frame = 0;
+    GpuResource upscaleProgram;
+};
+DynamicResolution g_dynRes;
+
+const char* upscaleFragmentShader = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D sceneColor;\n"
+    "uniform vec2 uvScale;\n uniform vec2 outputSize;\n uniform float sharpness;\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));\n"
+    "   vec2 uv = min(gl_FragCoord.xy / outputSize * uvScale, uvScale - 0.5 * texel);\n" // Não lê fora do retângulo renderizado
+    "   vec3 center = texture(sceneColor, uv).rgb;\n"
+    "   vec3 neighbors = texture(sceneColor, uv + vec2(texel.x, 0.0)).rgb + texture(sceneColor, uv - vec2(texel.x, 0.0)).rgb\n"
+    "                  + texture(sceneColor, uv + vec2(0.0, texel.y)).rgb + texture(sceneColor, uv - vec2(0.0, texel.y)).rgb;\n"
+    "   FragColor = vec4(clamp(center + sharpness * (4.0 * center - neighbors), 0.0, 1.0), 1.0);\n"
+    "}\n\0";
+
+void createDynamicResolution() {
+    for (int i = 0; i < DynamicResolution::QUERY_SLOTS; ++i) glGenQueries(2, g_dynRes.queries[i]);
+    g_dynRes.upscaleProgram = compileProgram({ fullscreenVertexShader }, { upscaleFragmentShader });
+    glUseProgram(g_dynRes.upscaleProgram);
+    glUniform1i(glGetUniformLocation(g_dynRes.upscaleProgram, "sceneColor"), 0);
+    glUseProgram(0);
+    // A cor da cena passa a ser amostrada com filtro bilinear no upscale
+    glBindTexture(GL_TEXTURE_2D, g_oit.sceneColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void destroyDynamicResolution() {
+    for (int i = 0; i < DynamicResolution::QUERY_SLOTS; ++i) glDeleteQueries(2, g_dynRes.queries[i]);
+    g_dynRes.upscaleProgram.reset();
+}
+
+void applyRenderScale(float scale) {
+    g_dynRes.scale = scale;
+    g_dynRes.width = std::max(8, std::min(WIDTH, (int)(WIDTH * scale / 8.0f + 0.5f) * 8));
+    g_dynRes.height = std::max(8, std::min(HEIGHT, (int)(HEIGHT * scale / 8.0f + 0.5f) * 8));
+}
+
+// Lê as medições prontas e decide a escala deste frame
+void updateDynamicResolution() {
+    DynamicResolution& d = g_dynRes;
+    for (int slot = 0; slot < DynamicResolution::QUERY_SLOTS; ++slot) {
+        if (!d.pending[slot]) continue;
+        int available = 0;
+        glGetQueryObjectiv(d.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(d.queries[slot][0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(d.queries[slot][1], GL_QUERY_RESULT, &end);
+        float ms = (end - start) / 1.0e6f;
+        d.gpuMs = (d.gpuMs == 0.0f) ? ms : d.gpuMs * 0.8f + ms * 0.2f;
+        d.pending[slot] = false;
+    }
+
+    if (!g_dynamicResolution) { applyRenderScale(1.0f); return; }
+    if (d.cooldown > 0) { d.cooldown--; return; }
+    if (d.gpuMs <= 0.0f) return;
+    float band = d.targetMs * d.hysteresisPct / 100.0f;
+    if (std::fabs(d.gpuMs - d.targetMs) <= band) return;
+    // Custo ~ proporcional à área: escala linear com a raiz da razão
+    float desired = d.scale * std::sqrt(d.targetMs / d.gpuMs);
+    desired = glm::clamp(desired, d.scale - d.maxStep, d.scale + d.maxStep);
+    desired = glm::clamp(desired, d.minScale, d.maxScale);
+    if (std::fabs(desired - d.scale) < 0.005f) return;
+    applyRenderScale(desired);
+    d.cooldown = d.settleFrames;
+}
+
+void beginSceneTiming() {
+    int slot = g_dynRes.frame % DynamicResolution::QUERY_SLOTS;
+    if (g_dynRes.pending[slot]) return; // Ainda sem resultado: pula a medição deste frame
+    glQueryCounter(g_dynRes.queries[slot][0], GL_TIMESTAMP);
+}
+
+void endSceneTiming() {
+    int slot = g_dynRes.frame % DynamicResolution::QUERY_SLOTS;
+    g_dynRes.frame++;
+    if (g_dynRes.pending[slot]) return;
+    glQueryCounter(g_dynRes.queries[slot][1], GL_TIMESTAMP);
+    g_dynRes.pending[slot] = true;
+}
+
+// Amplia o retângulo renderizado para a janela inteira
+void upscaleToWindow() {
+    bindFramebuffer(0);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    setCapability(GL_DEPTH_TEST, false);
+    setCapability(GL_BLEND, false);
+    useProgram(g_dynRes.upscaleProgram);
+    setUniform2f("uvScale", (float)g_dynRes.width / WIDTH, (float)g_dynRes.height / HEIGHT);
+    setUniform2f("outputSize", (float)WIDTH, (float)HEIGHT);
+    setUniform1f("sharpness", g_dynRes.scale < 1.0f ? g_dynRes.sharpness : 0.0f);
+    bindTexture(0, GL_TEXTURE_2D, g_oit.sceneColor);
+    bindVertexArray(g_oit.emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    g_frameStats.drawCalls++;
+}
+
+// Viewport de uma câmera dentro do retângulo de render atual
+struct ViewRect { int x, y, width, height; };
+
+ViewRect viewRect(const CameraView& view) {
+    ViewRect r;
+    r.x = (int)(view.x * g_dynRes.width); r.y = (int)(view.y * g_dynRes.height);
+    r.width = (int)(view.width * g_dynRes.width); r.height = (int)(view.height * g_dynRes.height);
+    return r;
+}
+
+
+// --- LATÊNCIA DE ENTRADA ---
+// Cada entrada (teclas, mouse, escolha do chute) leva o horário em que chegou (noteInput); o primeiro frame que a
+// reflete guarda esse horário até a GPU terminar de desenhá-lo: query GL_TIMESTAMP logo depois do swap, convertida
+// para o relógio do CPU. No modo de baixa latência (g_lowLatency) o frame só começa quando a GPU tem no máximo
+// maxQueuedFrames frames pendentes (fences), a câmera é lida de novo logo antes de desenhar e, com vsync, o início
+// do frame é atrasado para que a entrada seja lida o mais perto possível da troca.
+const int LATENCY_SLOTS = 4;       // Frames em voo acompanhados
+const int LATENCY_HISTORY = 4096;  // Amostras guardadas para as estatísticas (ring)
+const double PACING_MARGIN_MS = 2.0; // Folga do ritmo sobre a estimativa de trabalho do frame
+
+struct LatencyTracker {
+    int maxQueuedFrames = 1;  // --max-queued-frames (só no modo de baixa latência)
+    int swapInterval = 1;     // --swap-interval (0 = sem vsync)
+    double refreshPeriod = 1.0 / 60.0;
+    unsigned int queries[LATENCY_SLOTS];
+    GLsync fences[LATENCY_SLOTS] = {};
+    double inputTime[LATENCY_SLOTS] = {};
+    bool pending[LATENCY_SLOTS] = {};
+    int frame = 0;
+    double clockCpu = 0.0; GLint64 clockGpu = 0; // Calibração: o mesmo instante nos dois relógios
+    double frameStart = 0.0, lastSwap = 0.0, workMs = 4.0;
+    double history[LATENCY_HISTORY];  // Entrada -> GPU terminou o frame (ms)
+    unsigned long long samples = 0;
+    double lastMs = 0.0;
+    double toSwapSumMs = 0.0; unsigned long long toSwapSamples = 0; // Entrada -> glfwSwapBuffers retornou
+    double queueWaitMs = 0.0, pacingSleepMs = 0.0;                  // Tempo total segurado pelo modo
+};
+LatencyTracker g_latency;
+
+void calibrateGpuClock() {
+    glGetInteger64v(GL_TIMESTAMP, &g_latency.clockGpu);
+    g_latency.clockCpu = glfwGetTime();
+}
+
+void createLatencyTracker() {
+    glGenQueries(LATENCY_SLOTS, g_latency.queries);
+    g_latency.maxQueuedFrames = glm::clamp(g_latency.maxQueuedFrames, 1, LATENCY_SLOTS - 1);
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    if (mode && mode->refreshRate > 0) g_latency.refreshPeriod = 1.0 / mode->refreshRate;
+    glfwSwapInterval(g_latency.swapInterval);
+    calibrateGpuClock();
+}
+
+void destroyLatencyTracker() {
+    glDeleteQueries(LATENCY_SLOTS, g_latency.queries);
+    for (GLsync& fence : g_latency.fences) if (fence) { glDeleteSync(fence); fence = nullptr; }
+}
+
+// Fecha a amostra de um frame cuja query já saiu (wait = bloqueia até sair)
+void resolveLatency(int slot, bool wait) {
+    LatencyTracker& l = g_latency;
+    GLint available = 1;
+    if (!wait) glGetQueryObjectiv(l.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    GLuint64 gpuNs = 0;
+    glGetQueryObjectui64v(l.queries[slot], GL_QUERY_RESULT, &gpuNs);
+    l.pending[slot] = false;
+    if (l.inputTime[slot] == 0.0) return;
+    double done = l.clockCpu + ((double)gpuNs - (double)l.clockGpu) / 1.0e9;
+    l.lastMs = std::max(0.0, (done - l.inputTime[slot]) * 1000.0);
+    l.history[l.samples % LATENCY_HISTORY] = l.lastMs;
+    l.samples++;
+}
+
+// Início do frame, antes de ler a entrada
+void beginFrameLatency() {
+    LatencyTracker& l = g_latency;
+    if (g_lowLatency) {
+        // Fila limitada: espera a GPU terminar o frame de maxQueuedFrames atrás
+        GLsync fence = l.fences[(l.frame - l.maxQueuedFrames + LATENCY_SLOTS) % LATENCY_SLOTS];
+        if (fence && l.frame >= l.maxQueuedFrames) {
+            double start = glfwGetTime();
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms no pior caso
+            l.queueWaitMs += (glfwGetTime() - start) * 1000.0;
+        }
+        // Ritmo: com vsync, começa só a tempo de terminar antes da próxima troca
+        if (l.swapInterval > 0 && l.frame > 0) {
+            double wake = l.lastSwap + l.refreshPeriod * l.swapInterval - (l.workMs + PACING_MARGIN_MS) / 1000.0;
+            double now = glfwGetTime();
+            if (wake > now) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(wake - now));
+                l.pacingSleepMs += (glfwGetTime() - now) * 1000.0;
+            }
+        }
+    }
+    for (int slot = 0; slot < LATENCY_SLOTS; ++slot) if (l.pending[slot]) resolveLatency(slot, false);
+    if (glfwGetTime() - l.clockCpu > 1.0) calibrateGpuClock(); // Os relógios derivam devagar
+    l.frameStart = glfwGetTime();
+}
+
+// Logo depois do glfwSwapBuffers; submitted = horário em que o frame terminou de ser enviado (antes do swap)
+void endFrameLatency(double submitted) {
+    LatencyTracker& l = g_latency;
+    int slot = l.frame % LATENCY_SLOTS;
+    if (l.pending[slot]) resolveLatency(slot, true); // GPU com mais de LATENCY_SLOTS frames de atraso
+    glQueryCounter(l.queries[slot], GL_TIMESTAMP);
+    if (l.fences[slot]) glDeleteSync(l.fences[slot]);
+    l.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    l.inputTime[slot] = g_frameInputTime; l.pending[slot] = true;
+
+    double now = glfwGetTime();
+    if (g_frameInputTime > 0.0) { l.toSwapSumMs += (now - g_frameInputTime) * 1000.0; l.toSwapSamples++; }
+    g_frameInputTime = 0.0;
+    l.workMs += ((submitted - l.frameStart) * 1000.0 - l.workMs) * 0.1;
+    l.lastSwap = now;
+    l.frame++;
+}
+
+// Amostras [first, last) que ainda estão no histórico, na ordem (para o relatório e o benchmark)
+std::vector<double> latencySamples(unsigned long long first, unsigned long long last) {
+    if (last > (unsigned long long)LATENCY_HISTORY) first = std::max(first, last - LATENCY_HISTORY);
+    std::vector<double> samples;
+    for (unsigned long long i = first; i < last; ++i) samples.push_back(g_latency.history[i % LATENCY_HISTORY]);
+    return samples;
+}
+
+// Espera a GPU e fecha todas as amostras pendentes (fim de um cenário do benchmark)
+void flushLatency() {
+    for (int slot = 0; slot < LATENCY_SLOTS; ++slot) if (g_latency.pending[slot]) resolveLatency(slot, true);
+}
+
+void printLatencyStats() {
+    const LatencyTracker& l = g_latency;
+    if (l.samples == 0) return;
+    std::vector<double> samples = latencySamples(0, l.samples);
+    std::sort(samples.begin(), samples.end());
+    std::cout << "Latencia entrada -> tela (" << (g_lowLatency ? "baixa latencia" : "padrao") << ", swap interval " << l.swapInterval << "): "
+              << samples.size() << " amostras, p50 " << samples[samples.size() / 2]
+              << " ms, p95 " << samples[samples.size() * 95 / 100] << " ms; ate o swap media "
+              << (l.toSwapSamples > 0 ? l.toSwapSumMs / l.toSwapSamples : 0.0) << " ms; espera da fila "
+              << l.queueWaitMs << " ms, ritmo " << l.pacingSleepMs << " ms" << std::endl;
+}
+
+
+// --- HUD (texto e painéis) ---
+// Atlas de fonte montado na inicialização (stb_truetype com uma TTF do sistema ou --font; sem TTF, os glifos do
+// stb_easy_font são rasterizados no atlas). Cada rótulo guarda seus vértices e só é retesselado quando o texto
+// muda; todos os rótulos e painéis vão num único buffer dinâmico e saem numa só chamada de desenho.
+const int HUD_ATLAS_SIZE = 512;
+const int HUD_FIRST_CHAR = 32, HUD_CHAR_COUNT = 95; // ASCII imprimível
+const int HUD_MAX_LABEL_CHARS = 160;
+const int HUD_MAX_QUADS = 2048;
+
+const char* hudVertexShader = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"   // Pixels, origem no canto superior esquerdo
+    "layout (location = 1) in vec2 aUV;\n"
+    "layout (location = 2) in vec4 aColor;\n"
+    "uniform vec2 screenSize;\n"
+    "out vec2 UV;\n out vec4 Color;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(aPos.x / screenSize.x * 2.0 - 1.0, 1.0 - aPos.y / screenSize.y * 2.0, 0.0, 1.0);\n"
+    "   UV = aUV; Color = aColor;\n"
+    "}\0";
+const char* hudFragmentShader = "#version 330 core\n"
+    "in vec2 UV;\n in vec4 Color;\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D atlas;\n"
+    "void main()\n"
+    "{\n"
+    "   FragColor = vec4(Color.rgb, Color.a * texture(atlas, UV).r);\n"
+    "}\n\0";
+
+struct HudVertex { float x, y, u, v; uint8_t color[4]; };
+struct GlyphInfo { float u0, v0, u1, v1; float xoff, yoff, width, height, advance; };
+
+// Contadores em linhas curtas (HUD_PERF ... HUD_PERF + HUD_PERF_LINES - 1): cada uma cabe no rótulo e na largura da janela
+enum HudLabelId { HUD_SCORE, HUD_KICK, HUD_PROMPT, HUD_PERF, HUD_PERF_VIEW, HUD_PERF_CULLING, HUD_PERF_EFFECTS, HUD_LABEL_COUNT };
+const int HUD_PERF_LINES = HUD_LABEL_COUNT - HUD_PERF;
+enum HudAlign { HUD_ALIGN_LEFT, HUD_ALIGN_CENTER };
+
+struct HudLabel {
+    char text[HUD_MAX_LABEL_CHARS] = "";
+    float x = 0.0f, y = 0.0f, scale = 1.0f; // y = linha de base
+    HudAlign align = HUD_ALIGN_LEFT;
+    glm::vec4 color{1.0f}, panelColor{0.0f}; // panelColor.a == 0: sem painel
+    std::vector<HudVertex> vertices;         // Reservado uma vez; retesselado só quando o texto muda
+};
+
+struct Hud {
+    GlyphInfo glyphs[HUD_CHAR_COUNT];
+    float lineHeight = 0.0f, ascent = 0.0f;
+    float whiteU = 0.0f, whiteV = 0.0f; // Texel branco do atlas para os painéis
+    HudLabel labels[HUD_LABEL_COUNT];
+    std::vector<HudVertex> vertices;    // Todos os rótulos concatenados (o que vai para a GPU)
+    bool dirty = true;
+    GpuResource program, atlasTexture, vao, vbo;
+    GpuSlice indices;                   // Índices fixos, no arena de geometria estática
+    // Contadores de desempenho, atualizados 4x por segundo
+    double perfWindowStart = 0.0; int perfFrames = 0;
+    int retessellations = 0;
+};
+Hud g_hud;
+std::string g_hudFontPath;       // --font arquivo.ttf
+
+void putPixelRect(unsigned char* atlas, int x0, int y0, int x1, int y1) {
+    for (int y = std::max(y0, 0); y < std::min(y1, HUD_ATLAS_SIZE); ++y)
+        for (int x = std::max(x0, 0); x < std::min(x1, HUD_ATLAS_SIZE); ++x) atlas[y * HUD_ATLAS_SIZE + x] = 255;
+}
+
+bool bakeTrueTypeAtlas(const std::string& path, unsigned char* atlas) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<unsigned char> fontData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const float pixelHeight = 22.0f;
+    stbtt_bakedchar baked[HUD_CHAR_COUNT];
+    if (stbtt_BakeFontBitmap(fontData.data(), 0, pixelHeight, atlas, HUD_ATLAS_SIZE, HUD_ATLAS_SIZE, HUD_FIRST_CHAR, HUD_CHAR_COUNT, baked) <= 0) return false;
+    for (int i = 0; i < HUD_CHAR_COUNT; ++i) {
+        const stbtt_bakedchar& b = baked[i];
+        GlyphInfo& g = g_hud.glyphs[i];
+        g.u0 = b.x0 / (float)HUD_ATLAS_SIZE; g.v0 = b.y0 / (float)HUD_ATLAS_SIZE;
+        g.u1 = b.x1 / (float)HUD_ATLAS_SIZE; g.v1 = b.y1 / (float)HUD_ATLAS_SIZE;
+        g.xoff = b.xoff; g.yoff = b.yoff; g.width = (float)(b.x1 - b.x0); g.height = (float)(b.y1 - b.y0);
+        g.advance = b.xadvance;
+    }
+    g_hud.lineHeight = pixelHeight; g_hud.ascent = pixelHeight * 0.75f;
+    std::cout << "HUD: fonte " << path << std::endl;
+    return true;
+}
+
+// Sem TTF: rasteriza os retângulos que o stb_easy_font gera para cada caractere
+void bakeEasyFontAtlas(unsigned char* atlas) {
+    const int scale = 2, cellWidth = 16 * scale, cellHeight = 12 * scale;
+    const int columns = HUD_ATLAS_SIZE / cellWidth;
+    static char quadBuffer[16 * 1024];
+    for (int i = 0; i < HUD_CHAR_COUNT; ++i) {
+        char text[2] = { (char)(HUD_FIRST_CHAR + i), 0 };
+        unsigned char color[4] = { 255, 255, 255, 255 };
+        int cellX = (i % columns) * cellWidth, cellY = (i / columns) * cellHeight;
+        int quads = stb_easy_font_print(0.0f, 0.0f, text, color, quadBuffer, sizeof(quadBuffer));
+        const float* vertex = reinterpret_cast<const float*>(quadBuffer); // x, y, z + 4 bytes de cor por vértice
+        for (int q = 0; q < quads; ++q, vertex += 16) {
+            float x0 = std::min(vertex[0], vertex[8]), x1 = std::max(vertex[0], vertex[8]);
+            float y0 = std::min(vertex[1], vertex[9]), y1 = std::max(vertex[1], vertex[9]);
+            putPixelRect(atlas, cellX + (int)(x0 * scale), cellY + (int)(y0 * scale), cellX + (int)(x1 * scale), cellY + (int)(y1 * scale));
+        }
+        GlyphInfo& g = g_hud.glyphs[i];
+        g.u0 = cellX / (float)HUD_ATLAS_SIZE; g.v0 = cellY / (float)HUD_ATLAS_SIZE;
+        g.u1 = (cellX + cellWidth) / (float)HUD_ATLAS_SIZE; g.v1 = (cellY + cellHeight) / (float)HUD_ATLAS_SIZE;
+        g.xoff = 0.0f; g.yoff = -8.0f * scale; g.width = (float)cellWidth; g.height = (float)cellHeight;
+        g.advance = (float)(stb_easy_font_width(text) * scale);
+    }
+    g_hud.lineHeight = (float)cellHeight; g_hud.ascent = 8.0f * scale;
+    std::cout << "HUD: nenhuma fonte TTF encontrada, usando stb_easy_font" << std::endl;
+}
+
+void createHud() {
+    std::vector<unsigned char> atlas(HUD_ATLAS_SIZE * HUD_ATLAS_SIZE, 0);
+    const char* fontCandidates[] = { "C:/Windows/Fonts/consola.ttf", "C:/Windows/Fonts/arial.ttf",
+                                     "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf", "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+                                     "/Library/Fonts/Arial.ttf" };
+    bool baked = !g_hudFontPath.empty() && bakeTrueTypeAtlas(g_hudFontPath, atlas.data());
+    for (const char* candidate : fontCandidates) { if (baked) break; baked = bakeTrueTypeAtlas(candidate, atlas.data()); }
+    if (!baked) bakeEasyFontAtlas(atlas.data());
+    // Bloco branco no canto inferior direito do atlas (painéis usam o mesmo shader e a mesma chamada)
+    putPixelRect(atlas.data(), HUD_ATLAS_SIZE - 4, HUD_ATLAS_SIZE - 4, HUD_ATLAS_SIZE, HUD_ATLAS_SIZE);
+    g_hud.whiteU = g_hud.whiteV = (HUD_ATLAS_SIZE - 2.0f) / HUD_ATLAS_SIZE;
+
+    g_hud.atlasTexture = GpuResource(GPU_TEXTURE, GPU_CAT_TEXTURES, "atlas do HUD");
+    glBindTexture(GL_TEXTURE_2D, g_hud.atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, HUD_ATLAS_SIZE, HUD_ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, baked ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, baked ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    g_hud.atlasTexture.setBytes(atlas.size());
+
+    g_hud.program = compileProgram({ hudVertexShader }, { hudFragmentShader });
+    glUseProgram(g_hud.program);
+    glUniform1i(glGetUniformLocation(g_hud.program, "atlas"), 0);
+    glUseProgram(0);
+
+    // Buffer dinâmico de vértices + índices fixos de quads (0,1,2, 0,2,3)
+    std::vector<uint16_t> indices;
+    indices.reserve(HUD_MAX_QUADS * 6);
+    for (int q = 0; q < HUD_MAX_QUADS; ++q) {
+        uint16_t base = (uint16_t)(q * 4);
+        uint16_t quad[6] = { base, (uint16_t)(base + 1), (uint16_t)(base + 2), base, (uint16_t)(base + 2), (uint16_t)(base + 3) };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+    g_hud.indices = suballocate(g_staticGeometry, indices.size() * sizeof(uint16_t), 16, indices.data());
+    g_hud.vao = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_FRAME_DATA, "VAO do HUD");
+    g_hud.vbo = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "vertices do HUD");
+    glBindVertexArray(g_hud.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, g_hud.vbo);
+    glBufferData(GL_ARRAY_BUFFER, HUD_MAX_QUADS * 4 * sizeof(HudVertex), NULL, GL_DYNAMIC_DRAW);
+    g_hud.vbo.setBytes(HUD_MAX_QUADS * 4 * sizeof(HudVertex));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_hud.indices.buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, x)); glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)offsetof(HudVertex, u)); glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void*)offsetof(HudVertex, color)); glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+    // Layout fixo dos rótulos (pixels da janela)
+    HudLabel* labels = g_hud.labels;
+    labels[HUD_SCORE].x = WIDTH / 2.0f; labels[HUD_SCORE].y = 40.0f; labels[HUD_SCORE].scale = 1.4f; labels[HUD_SCORE].align = HUD_ALIGN_CENTER;
+    labels[HUD_SCORE].panelColor = glm::vec4(0.0f, 0.0f, 0.0f, 0.6f);
+    labels[HUD_KICK].x = WIDTH / 2.0f; labels[HUD_KICK].y = 72.0f; labels[HUD_KICK].align = HUD_ALIGN_CENTER;
+    labels[HUD_KICK].color = glm::vec4(0.9f, 0.9f, 0.6f, 1.0f);
+    labels[HUD_PROMPT].x = WIDTH / 2.0f; labels[HUD_PROMPT].y = HEIGHT - 30.0f; labels[HUD_PROMPT].align = HUD_ALIGN_CENTER;
+    labels[HUD_PROMPT].panelColor = glm::vec4(0.0f, 0.0f, 0.0f, 0.5f);
+    // Abaixo do placar e da cobrança, para não cruzar com eles
+    for (int line = 0; line < HUD_PERF_LINES; ++line) {
+        HudLabel& perf = labels[HUD_PERF + line];
+        perf.x = 10.0f; perf.y = 100.0f + line * g_hud.lineHeight * 0.8f; perf.scale = 0.7f;
+        perf.color = glm::vec4(0.7f, 1.0f, 0.7f, 1.0f);
+        perf.panelColor = glm::vec4(0.0f, 0.0f, 0.0f, 0.4f);
+    }
+    for (HudLabel& label : g_hud.labels) label.vertices.reserve((HUD_MAX_LABEL_CHARS + 1) * 4);
+    g_hud.vertices.reserve(HUD_MAX_QUADS * 4);
+}
+
+void destroyHud() {
+    g_hud.vao.reset();
+    g_hud.vbo.reset();
+    g_hud.atlasTexture.reset();
+    g_hud.program.reset();
+}
+
+void pushHudQuad(std::vector<HudVertex>& out, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const glm::vec4& color) {
+    uint8_t c[4] = { (uint8_t)(color.r * 255.0f), (uint8_t)(color.g * 255.0f), (uint8_t)(color.b * 255.0f), (uint8_t)(color.a * 255.0f) };
+    HudVertex quad[4] = { { x0, y0, u0, v0, {c[0], c[1], c[2], c[3]} }, { x1, y0, u1, v0, {c[0], c[1], c[2], c[3]} },
+                          { x1, y1, u1, v1, {c[0], c[1], c[2], c[3]} }, { x0, y1, u0, v1, {c[0], c[1], c[2], c[3]} } };
+    out.insert(out.end(), quad, quad + 4);
+}
+
+void tessellateLabel(HudLabel& label) {
+    label.vertices.clear();
+    float width = 0.0f;
+    for (const char* p = label.text; *p; ++p) {
+        int index = (unsigned char)*p - HUD_FIRST_CHAR;
+        if (index >= 0 && index < HUD_CHAR_COUNT) width += g_hud.glyphs[index].advance * label.scale;
+    }
+    float penX = (label.align == HUD_ALIGN_CENTER) ? label.x - width / 2.0f : label.x;
+    if (label.panelColor.a > 0.0f && label.text[0]) {
+        float pad = 6.0f * label.scale;
+        pushHudQuad(label.vertices, penX - pad, label.y - g_hud.ascent * label.scale - pad, penX + width + pad, label.y + (g_hud.lineHeight - g_hud.ascent) * label.scale + pad,
+                    g_hud.whiteU, g_hud.whiteV, g_hud.whiteU, g_hud.whiteV, label.panelColor);
+    }
+    for (const char* p = label.text; *p; ++p) {
+        int index = (unsigned char)*p - HUD_FIRST_CHAR;
+        if (index < 0 || index >= HUD_CHAR_COUNT) continue;
+        const GlyphInfo& g = g_hud.glyphs[index];
+        if (*p != ' ') {
+            float x0 = penX + g.xoff * label.scale, y0 = label.y + g.yoff * label.scale;
+            pushHudQuad(label.vertices, x0, y0, x0 + g.width * label.scale, y0 + g.height * label.scale, g.u0, g.v0, g.u1, g.v1, label.color);
+        }
+        penX += g.advance * label.scale;
+    }
+    g_hud.retessellations++;
+}
+
+// Troca o texto de um rótulo; só retessela (e marca o buffer para reenvio) se o texto mudou
+void setHudText(HudLabelId id, const char* format, ...) {
+    char text[HUD_MAX_LABEL_CHARS];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    HudLabel& label = g_hud.labels[id];
+    if (std::strcmp(text, label.text) == 0) return;
+    std::memcpy(label.text, text, sizeof(text));
+    tessellateLabel(label);
+    g_hud.dirty = true;
+}
+
+char kickResultSymbol(int result) { return result == 1 ? 'O' : result == 2 ? 'X' : '-'; }
+
+void updateHud() {
+    int score1 = 0, score2 = 0;
+    for (int i = 0; i < 3; ++i) { score1 += (g_team1Results[i] == 1); score2 += (g_team2Results[i] == 1); }
+    setHudText(HUD_SCORE, "TIME 1  %c%c%c  %d x %d  %c%c%c  TIME 2", kickResultSymbol(g_team1Results[0]), kickResultSymbol(g_team1Results[1]), kickResultSymbol(g_team1Results[2]),
+               score1, score2, kickResultSymbol(g_team2Results[0]), kickResultSymbol(g_team2Results[1]), kickResultSymbol(g_team2Results[2]));
+    setHudText(HUD_KICK, "Cobranca %d de 6 - Time %d", std::min(g_currentKick + 1, 6), g_currentKicker == TEAM_1 ? 1 : 2);
+
+    const char* prompt = "";
+    switch (g_gameState) {
+        case STATE_READY:    prompt = "Escolha o canto: 1 (esquerda)  2 (centro)  3 (direita)"; break;
+        case STATE_GOAL:     prompt = "GOL!"; break;
+        case STATE_SAVED:    prompt = "DEFENDEU!"; break;
+        case STATE_GAMEOVER: prompt = "FIM DE JOGO"; break;
+        default: break;
+    }
+    setHudText(HUD_PROMPT, "%s", prompt);
+
+    // Contadores de desempenho: média da janela de 250 ms
+    double now = glfwGetTime();
+    g_hud.perfFrames++;
+    if (now - g_hud.perfWindowStart >= 0.25) {
+        double frameMs = (now - g_hud.perfWindowStart) * 1000.0 / g_hud.perfFrames;
+        size_t textureBytes = 0;
+        int residentTextures = residentTextureCount(&textureBytes);
+        float occludedPct = g_frameStats.occlusionTested > 0 ? 100.0f * g_frameStats.occlusionRejected / g_frameStats.occlusionTested : 0.0f;
+        setHudText(HUD_PERF, "%.0f fps  %.2f ms | sim %.2f ms | audio %.0f us | gpu %.2f ms",
+                   1000.0 / frameMs, frameMs, g_frameStats.simMs, g_audio.mixUs.load(), g_dynRes.gpuMs);
+        setHudText(HUD_PERF_VIEW, "latencia %.1f ms%s | res %.0f%% %dx%d | texturas %d/%d %.1f MiB",
+                   g_latency.lastMs, g_lowLatency ? " (baixa)" : "", g_dynRes.scale * 100.0f, g_dynRes.width, g_dynRes.height,
+                   residentTextures, MAT_COUNT - 1, textureBytes / (1024.0 * 1024.0));
+        setHudText(HUD_PERF_CULLING, "cameras %d | draws %d | estado %d/%d | descartados %d | ocultos %.0f%%",
+                   g_frameStats.views, g_frameStats.drawCalls + 1, g_frameStats.stateIssued, g_frameStats.stateIssued + g_frameStats.stateSkipped,
+                   g_frameStats.culledItems, occludedPct);
+        setHudText(HUD_PERF_EFFECTS, "luzes %d (%d cortadas) | grama %d | particulas %d",
+                   g_frameStats.lights, g_frameStats.lightsDropped, g_frameStats.grassBlades, g_frameStats.particles);
+        g_hud.perfWindowStart = now; g_hud.perfFrames = 0;
+    }
+}
+
+// Desenha o HUD sobre a imagem final (framebuffer da janela): uma única chamada para tudo
+void renderHud() {
+    if (!g_showHud) return;
+    updateHud();
+    if (g_hud.dirty) {
+        g_hud.vertices.clear();
+        for (const HudLabel& label : g_hud.labels) {
+            size_t room = HUD_MAX_QUADS * 4 - g_hud.vertices.size();
+            g_hud.vertices.insert(g_hud.vertices.end(), label.vertices.begin(), label.vertices.begin() + std::min(room, label.vertices.size()));
+        }
+        bindBuffer(GL_ARRAY_BUFFER, g_hud.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, g_hud.vertices.size() * sizeof(HudVertex), g_hud.vertices.data());
+        g_hud.dirty = false;
+    }
+    if (g_hud.vertices.empty()) return;
+
+    glViewport(0, 0, WIDTH, HEIGHT);
+    setCapability(GL_DEPTH_TEST, false);
+    setCapability(GL_BLEND, true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    useProgram(g_hud.program);
+    setUniform2f("screenSize", (float)WIDTH, (float)HEIGHT);
+    bindTexture(0, GL_TEXTURE_2D, g_hud.atlasTexture);
+    bindVertexArray(g_hud.vao);
+    glDrawElements(GL_TRIANGLES, (GLsizei)(g_hud.vertices.size() / 4 * 6), GL_UNSIGNED_SHORT, (void*)g_hud.indices.offset);
+    g_frameStats.drawCalls++;
+}
+
+
+// --- RENDERIZAÇÃO NA GPU (multi-draw indireto) ---
+// Com GL 4.3+ (llvmpipe do Mesa dá 4.5) os opacos não passam mais um a um pelo CPU: os itens da lista vão para um
+// storage buffer, um compute shader faz o frustum culling por câmera e escreve os DrawElementsIndirectCommand,
+// e cada material sai num único glMultiDrawElementsIndirect (um comando por malha). Os comandos ficam em
+// [material][malha]; o índice do objeto chega ao vertex shader como atributo por instância lido da lista de
+// visíveis (baseInstance = início da faixa do comando). Translúcidos continuam no caminho do CPU (OIT/ordenação).
+// A oclusão usa a mesma pirâmide do Z hierárquico do CPU: os níveis da câmera sobem num storage buffer e o compute
+// testa a esfera de cada objeto dentro do frustum (o CPU não percorre mais a lista por câmera). As contagens de
+// testados/descartados voltam por um buffer de estatísticas lido alguns frames depois, sem esperar a GPU.
+// Sem GL 4.3, ou com --no-gpu-driven / tecla G, tudo volta para drawItem.
+struct GpuObject {              // std430: 96 bytes
+    float modelRows[12];        // Affine3x4
+    float color[4];
+    float bounds[4];
+    uint32_t bin, occluder, pad[2]; // bin = material * MESH_COUNT + malha; oclusores não se testam contra o Z
+};
+
+struct DrawElementsIndirectCommand { uint32_t count, instanceCount, firstIndex; int32_t baseVertex; uint32_t baseInstance; };
+
+const int GPU_BIN_COUNT = MAT_COUNT * MESH_COUNT;
+const int GPU_CULL_GROUP = 64;
+const int GPU_STATS_SLOTS = 3; // Buffers de estatísticas do cull em voo
+
+struct GpuDrivenRenderer {
+    bool supported = false;
+    GpuResource vao; // Mesmo VBO/EBO de SceneMeshes + atributo 2 (índice do objeto) por instância
+    GpuResource objectBuffer, visibleBuffer, commandBuffer;
+    GpuResource hizBuffer; // Níveis do Z hierárquico da câmera corrente, em sequência
+    GpuResource statsBuffers[GPU_STATS_SLOTS]; // Testados/descartados pela oclusão no frame (2 uints)
+    GLsync statsFences[GPU_STATS_SLOTS] = {};
+    int statsFrame = 0;
+    GpuResource cullProgram, drawProgram;
+    std::vector<GpuObject> objects;
+    DrawElementsIndirectCommand commands[GPU_BIN_COUNT]; // Modelo com instanceCount = 0, reenviado por câmera
+    int binObjects[GPU_BIN_COUNT];
+    size_t visibleCapacity = 0;
+    const DrawList* uploadedList = nullptr; // Lista já enviada neste frame (o replay tem outra)
+};
+GpuDrivenRenderer g_gpuScene;
+
+const char* gpuObjectStruct =
+    "struct Object { vec4 modelRows[3]; vec4 color; vec4 bounds; uvec4 info; };\n"
+    "layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };\n";
+
+// Um invocation por objeto: testa a esfera contra os planos de viewProjection e contra o Z hierárquico e entra no
+// comando do seu bin. sphereScreenExtent/sphereOccluded são as mesmas contas do CPU (OCC_* vêm de gpuOcclusionHeader).
+const char* gpuCullComputeShader =
+    "layout (local_size_x = 64) in;\n"
+    "layout (std430, binding = 1) buffer Commands { uint commands[]; };\n" // 5 uints por comando
+    "layout (std430, binding = 2) writeonly buffer Visible { uint visible[]; };\n"
+    "layout (std430, binding = 3) readonly buffer HiZ { float hiz[]; };\n" // levels[0..OCC_LEVELS-1], 1/w
+    "layout (std430, binding = 4) buffer CullStats { uint occlusionTested; uint occlusionRejected; };\n"
+    "uniform mat4 viewProjection;\n uniform int objectCount;\n uniform bool useOcclusion;\n"
+    "uniform mat4 occlusionView;\n uniform vec2 occlusionScale;\n" // projection[0][0], projection[1][1]
+    "void sphereScreenExtent(vec2 c, float depth, float radius, out vec2 lo, out vec2 hi)\n"
+    "{\n"
+    "   vec2 t = sqrt(max(c * c + depth * depth - radius * radius, 0.0));\n"
+    "   lo = (c * t - radius * depth) / (depth * t + c * radius);\n"
+    "   hi = (c * t + radius * depth) / (depth * t - c * radius);\n"
+    "}\n"
+    "bool sphereOccluded(vec4 sphere)\n"
+    "{\n"
+    "   vec3 center = (occlusionView * vec4(sphere.xyz, 1.0)).xyz;\n"
+    "   float distance = -center.z, nearest = distance - sphere.w;\n"
+    "   if (nearest < OCC_NEAR) return false;\n"
+    "   vec2 lo, hi;\n"
+    "   sphereScreenExtent(center.xy, distance, sphere.w, lo, hi);\n"
+    "   vec2 minUV = occlusionScale * lo * 0.5 + 0.5, maxUV = occlusionScale * hi * 0.5 + 0.5;\n"
+    "   if (any(lessThan(maxUV, vec2(0.0))) || any(greaterThan(minUV, vec2(1.0)))) return false;\n"
+    "   minUV = max(minUV, vec2(0.0)); maxUV = min(maxUV, vec2(1.0));\n"
+    "   ivec2 size = ivec2(OCC_WIDTH, OCC_HEIGHT);\n"
+    "   float spanPixels = max((maxUV.x - minUV.x) * float(size.x), (maxUV.y - minUV.y) * float(size.y));\n"
+    "   int level = 0, offset = 0;\n"
+    "   while (level < OCC_LEVELS - 1 && spanPixels > 4.0) { spanPixels *= 0.5; offset += size.x * size.y; size >>= 1; level++; }\n"
+    "   ivec2 p0 = min(ivec2(minUV * vec2(size)), size - 1), p1 = min(ivec2(maxUV * vec2(size)), size - 1);\n"
+    "   float objectDepth = 1.0 / nearest;\n"
+    "   for (int y = p0.y; y <= p1.y; ++y)\n"
+    "       for (int x = p0.x; x <= p1.x; ++x)\n"
+    "           if (hiz[offset + y * size.x + x] <= objectDepth) return false;\n"
+    "   return true;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "   uint i = gl_GlobalInvocationID.x;\n"
+    "   if (i >= uint(objectCount)) return;\n"
+    "   vec4 sphere = objects[i].bounds;\n"
+    "   mat4 m = transpose(viewProjection);\n" // Linhas de viewProjection (Gribb-Hartmann, como frustumFromMatrix)
+    "   for (int p = 0; p < 6; ++p) {\n"
+    "       vec4 plane = m[3] + (p % 2 == 0 ? 1.0 : -1.0) * m[p / 2];\n"
+    "       if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w * length(plane.xyz)) return;\n"
+    "   }\n"
+    "   if (useOcclusion && objects[i].info.y == 0u) {\n"
+    "       atomicAdd(occlusionTested, 1u);\n"
+    "       if (sphereOccluded(sphere)) { atomicAdd(occlusionRejected, 1u); return; }\n"
+    "   }\n"
+    "   uint bin = objects[i].info.x;\n"
+    "   uint slot = atomicAdd(commands[bin * 5u + 1u], 1u);\n"
+    "   visible[commands[bin * 5u + 4u] + slot] = i;\n"
+    "}\n\0";
+
+const char* gpuVertexShader =
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec3 aNormal;\n"
+    "layout (location = 2) in uint aObject;\n" // visible[baseInstance + gl_InstanceID]
+    "uniform mat4 view;\n uniform mat4 projection;\n"
+    "out vec3 FragPos;\n out vec3 Normal;\n"
+    "out vec3 LocalPos;\n out vec3 LocalNormal;\n"
+    "flat out vec4 objectColor;\n"
+    "void main()\n"
+    "{\n"
+    "   Object o = objects[aObject];\n"
+    "   mat4x3 model = transpose(mat3x4(o.modelRows[0], o.modelRows[1], o.modelRows[2]));\n"
+    "   objectColor = o.color;\n"
+    "   LocalPos = aPos; LocalNormal = aNormal;\n"
+    "   FragPos = model * vec4(aPos, 1.0);\n"
+    "   gl_Position = projection * view * vec4(FragPos, 1.0);\n"
+    "   Normal = transpose(inverse(mat3(model))) * aNormal;\n"
+    "}\0";
+
+// Sobe os opacos da lista (uma vez por lista e frame) e monta o modelo dos comandos
+void uploadGpuObjects(const SceneMeshes& meshes, const DrawList& list) {
+    GpuDrivenRenderer& g = g_gpuScene;
+    if (g.uploadedList == &list) return;
+    g.uploadedList = &list;
+    std::fill(std::begin(g.binObjects), std::end(g.binObjects), 0);
+    g.objects.clear();
+    for (const DrawItem& item : list) {
+        if (item.color.a < 1.0f) continue;
+        GpuObject object;
+        std::memcpy(object.modelRows, &item.model.m[0][0], sizeof(object.modelRows));
+        object.color[0] = item.color.r; object.color[1] = item.color.g; object.color[2] = item.color.b; object.color[3] = item.color.a;
+        object.bounds[0] = item.bounds.x; object.bounds[1] = item.bounds.y; object.bounds[2] = item.bounds.z; object.bounds[3] = item.bounds.w;
+        object.bin = item.material * MESH_COUNT + item.mesh;
+        object.occluder = item.occluder ? 1u : 0u;
+        object.pad[0] = object.pad[1] = 0;
+        g.binObjects[object.bin]++;
+        g.objects.push_back(object);
+    }
+    uint32_t offset = 0;
+    for (int bin = 0; bin < GPU_BIN_COUNT; ++bin) {
+        const MeshRange& range = meshes.ranges[bin % MESH_COUNT];
+        g.commands[bin] = { (uint32_t)range.indexCount, 0u, (uint32_t)range.firstIndex, range.baseVertex, offset };
+        offset += g.binObjects[bin];
+    }
+
+    bindBuffer(GL_SHADER_STORAGE_BUFFER, g.objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(g.objects.size(), 1) * sizeof(GpuObject), g.objects.data(), GL_STREAM_DRAW);
+    g.objectBuffer.setBytes(std::max<size_t>(g.objects.size(), 1) * sizeof(GpuObject));
+    if (g.objects.size() > g.visibleCapacity) {
+        g.visibleCapacity = g.objects.size() + g.objects.size() / 2;
+        bindBuffer(GL_SHADER_STORAGE_BUFFER, g.visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, g.visibleCapacity * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+        g.visibleBuffer.setBytes(g.visibleCapacity * sizeof(uint32_t));
+    }
+}
+
+// Pirâmide do Z hierárquico desta câmera, níveis em sequência (orphan, como os comandos)
+void uploadGpuOcclusion(const OcclusionBuffer& occlusion) {
+    GpuDrivenRenderer& g = g_gpuScene;
+    size_t bytes = 0;
+    for (int level = 0; level < OCC_LEVELS; ++level) bytes += occlusion.levels[level].size() * sizeof(float);
+    bindBuffer(GL_SHADER_STORAGE_BUFFER, g.hizBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+    size_t offset = 0;
+    for (int level = 0; level < OCC_LEVELS; ++level) {
+        size_t levelBytes = occlusion.levels[level].size() * sizeof(float);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, levelBytes, occlusion.levels[level].data());
+        offset += levelBytes;
+    }
+    g.hizBuffer.setBytes(bytes);
+}
+
+// Estatísticas da oclusão na GPU: lê os slots cuja fence já passou (sem esperar) e zera o slot deste frame.
+// As contagens entram no frame em que chegam, alguns frames depois do cull que as gerou.
+void beginGpuCullStats() {
+    GpuDrivenRenderer& g = g_gpuScene;
+    if (!g.supported) return;
+    for (int slot = 0; slot < GPU_STATS_SLOTS; ++slot) {
+        if (!g.statsFences[slot]) continue;
+        GLenum status = glClientWaitSync(g.statsFences[slot], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+        uint32_t counts[2] = { 0, 0 };
+        bindBuffer(GL_SHADER_STORAGE_BUFFER, g.statsBuffers[slot]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+        g_frameStats.occlusionTested += (int)counts[0];
+        g_frameStats.occlusionRejected += (int)counts[1];
+        glDeleteSync(g.statsFences[slot]);
+        g.statsFences[slot] = nullptr;
+    }
+    int slot = g.statsFrame % GPU_STATS_SLOTS;
+    if (g.statsFences[slot]) { glDeleteSync(g.statsFences[slot]); g.statsFences[slot] = nullptr; } // GPU atrasada: descarta
+    uint32_t zero[2] = { 0, 0 };
+    bindBuffer(GL_SHADER_STORAGE_BUFFER, g.statsBuffers[slot]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+}
+
+void endGpuCullStats() {
+    GpuDrivenRenderer& g = g_gpuScene;
+    if (!g.supported) return;
+    int slot = g.statsFrame++ % GPU_STATS_SLOTS;
+    g.statsFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Culling dos opacos para uma câmera: zera as contagens dos comandos e preenche a lista de visíveis
+void cullGpuScene(const SceneMeshes& meshes, const CameraView& view, const DrawList& list, const OcclusionBuffer* occlusion) {
+    GpuDrivenRenderer& g = g_gpuScene;
+    uploadGpuObjects(meshes, list);
+    if (g.objects.empty()) return;
+    if (occlusion) uploadGpuOcclusion(*occlusion);
+
+    bindBuffer(GL_SHADER_STORAGE_BUFFER, g.commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(g.commands), g.commands, GL_STREAM_DRAW); // Orphan: a câmera anterior ainda pode estar lendo
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g.objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, g.commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, g.visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, g.hizBuffer); // Ligado mesmo sem oclusão (buffer mínimo)
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, g.statsBuffers[g.statsFrame % GPU_STATS_SLOTS]);
+    useProgram(g.cullProgram);
+    setUniformMatrix4("viewProjection", view.projection * view.view);
+    setUniform1i("objectCount", (int)g.objects.size());
+    setUniform1i("useOcclusion", occlusion ? 1 : 0);
+    if (occlusion) {
+        setUniformMatrix4("occlusionView", occlusion->view);
+        setUniform2f("occlusionScale", occlusion->projection[0][0], occlusion->projection[1][1]);
+    }
+    glDispatchCompute((GLuint)((g.objects.size() + GPU_CULL_GROUP - 1) / GPU_CULL_GROUP), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    g_frameStats.gpuObjects += (int)g.objects.size();
+}
+
+// Um multi-draw por material com objetos (drawProgram ligado, uniforms da câmera já enviados)
+void drawGpuScene() {
+    GpuDrivenRenderer& g = g_gpuScene;
+    if (g.objects.empty()) return;
+    bindVertexArray(g.vao);
+    bindBuffer(GL_DRAW_INDIRECT_BUFFER, g.commandBuffer);
+    for (int material = 0; material < MAT_COUNT; ++material) {
+        int objects = 0;
+        for (int mesh = 0; mesh < MESH_COUNT; ++mesh) objects += g.binObjects[material * MESH_COUNT + mesh];
+        if (objects == 0) continue;
+        const MaterialInfo& info = g_materialInfo[material];
+        setUniform1i("textureMode", info.textureMode);
+        setUniform1f("textureScale", info.textureScale);
+        if (info.textureMode != 0) bindTexture(ALBEDO_UNIT, GL_TEXTURE_2D, materialTexture(material));
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(material * MESH_COUNT * sizeof(DrawElementsIndirectCommand)), MESH_COUNT, 0);
+        g_frameStats.drawCalls++;
+    }
+}
+
+bool gpuDrivenActive() { return g_gpuScene.supported && g_gpuDriven; }
+
+void createGpuDriven(const SceneMeshes& meshes) {
+    GpuDrivenRenderer& g = g_gpuScene;
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major); glGetIntegerv(GL_MINOR_VERSION, &minor);
+    g.supported = major * 10 + minor >= 43;
+    if (!g.supported) {
+        std::cout << "GL " << major << "." << minor << ": sem compute/multi-draw indireto, submissao pelo CPU" << std::endl;
+        return;
+    }
+    char gpuOcclusionHeader[160];
+    std::snprintf(gpuOcclusionHeader, sizeof(gpuOcclusionHeader), "const int OCC_WIDTH = %d, OCC_HEIGHT = %d, OCC_LEVELS = %d;\nconst float OCC_NEAR = %.6f;\n",
+                  OCC_WIDTH, OCC_HEIGHT, OCC_LEVELS, OCC_NEAR);
+    g.cullProgram = compileComputeProgram({ "#version 430 core\n", gpuOcclusionHeader, gpuObjectStruct, gpuCullComputeShader });
+    g.drawProgram = compileProgram({ "#version 430 core\n", gpuObjectStruct, gpuVertexShader },
+                                   { objectColorVaryingHeader, lightingFragmentCommon, lightingFragmentShader });
+    bindSceneSamplers(g.drawProgram);
+    g.objects.reserve(4096);
+
+    g.objectBuffer = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "objetos (GPU-driven)");
+    g.visibleBuffer = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "visiveis (GPU-driven)");
+    g.commandBuffer = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "comandos indiretos");
+    glBindBuffer(GL_ARRAY_BUFFER, g.visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, 4096 * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+    g.visibleCapacity = 4096;
+    g.visibleBuffer.setBytes(g.visibleCapacity * sizeof(uint32_t));
+    g.commandBuffer.setBytes(sizeof(g.commands));
+    g.hizBuffer = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "Z hierarquico (GPU-driven)");
+    glBindBuffer(GL_ARRAY_BUFFER, g.hizBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float), NULL, GL_STREAM_DRAW);
+    g.hizBuffer.setBytes(sizeof(float));
+    for (int slot = 0; slot < GPU_STATS_SLOTS; ++slot) {
+        g.statsBuffers[slot] = GpuResource(GPU_BUFFER, GPU_CAT_FRAME_DATA, "estatisticas do cull");
+        glBindBuffer(GL_ARRAY_BUFFER, g.statsBuffers[slot]);
+        glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(uint32_t), NULL, GL_DYNAMIC_READ);
+        g.statsBuffers[slot].setBytes(2 * sizeof(uint32_t));
+    }
+    g.vao = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_GEOMETRY, "VAO (GPU-driven)");
+    glBindVertexArray(g.vao);
+    bindSceneMeshBuffers(meshes);
+    glBindBuffer(GL_ARRAY_BUFFER, g.visibleBuffer);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0); glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void destroyGpuDriven() {
+    GpuDrivenRenderer& g = g_gpuScene;
+    if (!g.supported) return;
+    g.vao.reset();
+    g.objectBuffer.reset(); g.visibleBuffer.reset(); g.commandBuffer.reset(); g.hizBuffer.reset();
+    for (int slot = 0; slot < GPU_STATS_SLOTS; ++slot) {
+        if (g.statsFences[slot]) glDeleteSync(g.statsFences[slot]);
+        g.statsFences[slot] = nullptr;
+        g.statsBuffers[slot].reset();
+    }
+    g.cullProgram.reset(); g.drawProgram.reset();
+}
+
+
+// --- MONTAGEM E SUBMISSÃO DA CENA ---
+// Simulação, animação e transformações: feitas uma vez por frame e compartilhadas entre as câmeras
+// Em duas etapas: os oclusores (gramado, arquibancadas) primeiro, para a oclusão começar enquanto o resto é montado
+void buildSceneOccluders(DrawList& list) {
+    g_drawList = &list;
+    drawField();
+    drawGrandstands();
+    g_drawList = nullptr;
+}
+
+void buildSceneDynamic(DrawList& list) {
+    g_drawList = &list;
+
+    // --- Objetos OPACOS ---
+    drawFieldMarkings();
+    drawScoreboard();
+
+    drawCrowd();
+
+    // Goleiro
+    drawKeeper(g_keeperPosition, g_keeperColor);
+
+    // Desenha o jogador ATIVO (com animação de corrida/chute)
+    if (g_gameState != STATE_GAMEOVER) {
+        drawPlayer(g_playerPosition, g_currentKicker);
+    }
+
+    // Bola (Esfera)
+    drawSphere(glm::scale(glm::translate(glm::mat4(1.0f), g_ballPosition), glm::vec3(g_ballRadius)), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    // --- Objetos TRANSPARENTES (Rede) --- a ordem aqui não importa mais (OIT / ordenação por câmera)
+    drawGoal();
+    drawTranslucentStress();
+
+    g_drawList = nullptr;
+}
+
+void buildScene(DrawList& list) {
+    buildSceneOccluders(list);
+    buildSceneDynamic(list);
+}
+
+// Por câmera: só culling e submissão.
+// Uniforms da câmera no programa atual
+void uploadViewUniforms(const CameraView& view) {
+    setUniformMatrix4("view", view.view);
+    setUniformMatrix4("projection", view.projection);
+    setUniform3f("lightPos", g_lightPos);
+    setUniform3f("viewPos", view.position);
+    setUniform3i("clusterDims", CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    ViewRect rect = viewRect(view);
+    setUniform4f("viewportRect", (float)rect.x, (float)rect.y, (float)rect.width, (float)rect.height);
+    setUniform2f("clusterDepth", CLUSTER_NEAR, CLUSTER_Z / std::log(CLUSTER_FAR / CLUSTER_NEAR));
+}
+
+// Mesh, material e cor repetidos de um item para o outro ficam no cache de estado GL
+void drawItem(const SceneMeshes& meshes, const DrawItem& item) {
+    bindVertexArray(meshes.vao);
+    const MaterialInfo& info = g_materialInfo[item.material];
+    setUniform1i("textureMode", info.textureMode);
+    setUniform1f("textureScale", info.textureScale);
+    if (info.textureMode != 0) bindTexture(ALBEDO_UNIT, GL_TEXTURE_2D, materialTexture(item.material));
+    uploadModel(item.model);
+    setUniform4f("objectColor", item.color.r, item.color.g, item.color.b, item.color.a);
+    const MeshRange& range = meshes.ranges[item.mesh];
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.firstIndex * sizeof(unsigned int)), range.baseVertex);
+    g_frameStats.drawCalls++;
+}
+
+// --- GRAMA (instâncias por chunk) ---
+// Tufos de grama sobre o gramado, dividido em chunks de GRASS_CHUNK_SIZE. Todos os chunks reusam o mesmo
+// tile de GRASS_TILE_BLADES tufos (buffer texture RGBA8, 64 KiB), girado/espelhado por chunk para não repetir.
+// O tile está em ordem aleatória: desenhar só as primeiras N instâncias dá uma amostra uniforme com densidade
+// menor, então a queda de densidade com a distância é só o número de instâncias do draw. Os últimos 20% do
+// prefixo crescem aos poucos (sem pipocar) e os chunks longe usam a lâmina de 1 segmento em vez de 3.
+// Por câmera: chunks fora do frustum são descartados, no máximo um draw por chunk e GRASS_VIEW_BUDGET tufos.
+const float GRASS_CHUNK_SIZE = 2.5f;
+const int GRASS_CHUNKS_X = 8, GRASS_CHUNKS_Z = 10; // Gramado de 20 x 25 m
+const int GRASS_CHUNK_COUNT = GRASS_CHUNKS_X * GRASS_CHUNKS_Z;
+const int GRASS_TILE_BLADES = 16384;
+const int GRASS_VIEW_BUDGET = 250000;
+const float GRASS_NEAR = 8.0f, GRASS_FAR = 35.0f; // Densidade cheia até NEAR, nenhuma a partir de FAR
+const float GRASS_LOD_DISTANCE = 14.0f;           // Lâmina de 3 segmentos até aqui
+const float GRASS_MIN_HEIGHT = 0.04f, GRASS_MAX_HEIGHT = 0.12f;
+const int GRASS_BLADE_UNIT = 6; // Unidade de textura do tile (ver ILUMINAÇÃO EM CLUSTERS)
+
+struct GrassSystem {
+    GpuResource bladeBuffer, bladeTexture;
+    GpuResource program, vao;
+    struct Chunk { float distance; int index, count, segments; };
+    Chunk visible[GRASS_CHUNK_COUNT];
+};
+GrassSystem g_grassSystem;
+
+// Lâmina gerada pelo gl_VertexID (strip de 2*segments+1 vértices, sem VBO); tufo vindo do tile no buffer texture.
+// O vento dobra a lâmina no vertex shader, mais na ponta; sobre as marcações do campo a grama fica pintada de branco.
+const char* grassVertexShader = "#version 330 core\n"
+    "uniform mat4 view;\n uniform mat4 projection;\n"
+    "uniform samplerBuffer grassBlades;\n" // (x, z no tile, ângulo, altura), normalizados
+    "uniform vec2 chunkCenter;\n uniform int chunkVariant;\n uniform int bladeCount;\n uniform int segments;\n"
+    "uniform float chunkSize;\n uniform vec2 heightRange;\n"
+    "uniform float time;\n uniform vec3 wind;\n" // xy: direção * força, z: velocidade das rajadas
+    "uniform vec4 markings[8];\n"                 // Faixas do campo: (centro, meia largura) em xz
+    "out vec3 FragPos;\n out vec3 Normal;\n"
+    "out vec3 LocalPos;\n out vec3 LocalNormal;\n"
+    "flat out vec4 objectColor;\n"
+    "float hash(int n) { n = (n << 13) ^ n; return float((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff) / 2147483647.0; }\n"
+    "void main()\n"
+    "{\n"
+    "   vec4 blade = texelFetch(grassBlades, gl_InstanceID);\n"
+    "   vec2 local = (blade.xy - 0.5) * chunkSize;\n"
+    "   if ((chunkVariant & 1) != 0) local.x = -local.x;\n"
+    "   if ((chunkVariant & 2) != 0) local = vec2(-local.y, local.x);\n"
+    "   if ((chunkVariant & 4) != 0) local = -local;\n"
+    "   vec2 root = chunkCenter + local;\n"
+    "   float grow = clamp((float(bladeCount) - float(gl_InstanceID)) / (0.2 * float(bladeCount)), 0.0, 1.0);\n"
+    "   float height = mix(heightRange.x, heightRange.y, blade.w) * grow;\n"
+    "   float painted = 0.0;\n"
+    "   for (int i = 0; i < 8; ++i) {\n"
+    "       vec2 d = max(abs(root - markings[i].xy) - markings[i].zw, 0.0);\n"
+    "       painted = max(painted, 1.0 - smoothstep(0.0, 0.02, length(d)));\n"
+    "   }\n"
+    "   float angle = blade.z * 6.2831853;\n"
+    "   vec2 across = vec2(cos(angle), sin(angle));\n"
+    "   vec2 facing = vec2(-across.y, across.x);\n"
+    "   int level = gl_VertexID >> 1;\n"
+    "   float t = float(level) / float(segments);\n"
+    "   float side = gl_VertexID == 2 * segments ? 0.0 : float(gl_VertexID & 1) - 0.5;\n"
+    "   float strength = length(wind.xy);\n"
+    "   vec2 windDir = strength > 0.0 ? wind.xy / strength : vec2(1.0, 0.0);\n"
+    "   float phase = dot(root, windDir) * 0.35 - time * wind.z;\n"
+    "   float sway = strength * (0.55 + 0.3 * sin(phase) + 0.15 * sin(phase * 2.7 + angle));\n"
+    "   vec2 bend = (facing * 0.3 + windDir * sway) * t * t;\n"
+    "   vec3 offset = vec3(across * side * 0.02 * (1.0 - t) + bend * height, t * height * (1.0 - 0.3 * min(dot(bend, bend), 1.0)));\n"
+    "   FragPos = vec3(root.x + offset.x, offset.z, root.y + offset.y);\n"
+    "   gl_Position = projection * view * vec4(FragPos, 1.0);\n"
+    "   Normal = normalize(vec3(facing.x * 0.4, 1.0, facing.y * 0.4));\n"
+    "   LocalPos = vec3(local.x, FragPos.y, local.y); LocalNormal = Normal;\n"
+    "   vec3 green = mix(vec3(0.04, 0.36, 0.07), vec3(0.16, 0.58, 0.12), hash(gl_InstanceID + chunkVariant * 7919));\n"
+    "   objectColor = vec4(mix(green, vec3(0.95), painted), 1.0);\n"
+    "}\0";
+
+// Tile em ordem aleatória (qualquer prefixo é uniforme sobre o chunk); semente fixa: igual em toda execução
+void createGrass() {
+    GrassSystem& g = g_grassSystem;
+    std::vector<uint8_t> blades(GRASS_TILE_BLADES * 4);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (uint8_t& b : blades) b = (uint8_t)byte(rng);
+    g.bladeTexture = createBufferTexture(g.bladeBuffer, GL_RGBA8, GPU_CAT_EFFECTS, "tile da grama");
+    glBindBuffer(GL_TEXTURE_BUFFER, g.bladeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, blades.size(), blades.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    g.bladeBuffer.setBytes(blades.size());
+
+    g.program = compileProgram({ grassVertexShader }, { objectColorVaryingHeader, lightingFragmentCommon, lightingFragmentShader });
+    bindSceneSamplers(g.program);
+    glUseProgram(g.program);
+    glUniform1i(glGetUniformLocation(g.program, "grassBlades"), GRASS_BLADE_UNIT);
+    glUniform1f(glGetUniformLocation(g.program, "chunkSize"), GRASS_CHUNK_SIZE);
+    glUniform2f(glGetUniformLocation(g.program, "heightRange"), GRASS_MIN_HEIGHT, GRASS_MAX_HEIGHT);
+    float markings[8 * 4];
+    for (int i = 0; i < 8; ++i) {
+        const FieldMarking& m = g_fieldMarkings[i];
+        markings[i * 4 + 0] = m.center.x; markings[i * 4 + 1] = m.center.y;
+        markings[i * 4 + 2] = m.halfSize.x; markings[i * 4 + 3] = m.halfSize.y;
+    }
+    glUniform4fv(glGetUniformLocation(g.program, "markings"), 8, markings);
+    glUseProgram(0);
+    g.vao = GpuResource(GPU_VERTEX_ARRAY, GPU_CAT_EFFECTS, "VAO da grama"); // Sem atributos: tudo vem do gl_VertexID / gl_InstanceID
+}
+
+void destroyGrass() {
+    GrassSystem& g = g_grassSystem;
+    g.bladeTexture.reset();
+    g.bladeBuffer.reset();
+    g.vao.reset();
+    g.program.reset();
+}
+
+// Escolhe densidade e LOD dos chunks visíveis e desenha do mais perto para o mais longe (ajuda o early-z).
+// Chamado com o programa da cena ainda por ativar: quem chama reativa o seu depois.
+void drawGrass(const CameraView& view) {
+    GrassSystem& g = g_grassSystem;
+    if (!g_grass || g_grassDensity <= 0.0f) return;
+    Frustum frustum = frustumFromMatrix(view.projection * view.view);
+    const float half = GRASS_CHUNK_SIZE * 0.5f;
+    int maxBlades = (int)(GRASS_TILE_BLADES * std::min(g_grassDensity, 1.0f));
+    int visibleCount = 0, total = 0;
+    for (int z = 0; z < GRASS_CHUNKS_Z; ++z) {
+        for (int x = 0; x < GRASS_CHUNKS_X; ++x) {
+            glm::vec2 center(-10.0f + (x + 0.5f) * GRASS_CHUNK_SIZE, -12.5f + (z + 0.5f) * GRASS_CHUNK_SIZE);
+            if (!sphereInFrustum(frustum, glm::vec4(center.x, GRASS_MAX_HEIGHT * 0.5f, center.y, half * 1.415f))) continue;
+            // Distância até o ponto mais próximo do chunk (não o centro): sem degrau de densidade ao cruzar a borda
+            float dx = std::max(std::abs(view.position.x - center.x) - half, 0.0f);
+            float dz = std::max(std::abs(view.position.z - center.y) - half, 0.0f);
+            float distance = std::sqrt(dx * dx + dz * dz + view.position.y * view.position.y);
+            float falloff = glm::clamp((GRASS_FAR - distance) / (GRASS_FAR - GRASS_NEAR), 0.0f, 1.0f);
+            int count = (int)(maxBlades * falloff * falloff);
+            if (count == 0) continue;
+            GrassSystem::Chunk& chunk = g.visible[visibleCount++];
+            chunk.distance = distance;
+            chunk.index = z * GRASS_CHUNKS_X + x;
+            chunk.count = count;
+            chunk.segments = distance < GRASS_LOD_DISTANCE ? 3 : 1;
+            total += count;
+        }
+    }
+    if (visibleCount == 0) return;
+    // Câmera colada no gramado: corta todos os chunks na mesma proporção para caber no orçamento
+    if (total > GRASS_VIEW_BUDGET) {
+        float scale = (float)GRASS_VIEW_BUDGET / total;
+        for (int i = 0; i < visibleCount; ++i) g.visible[i].count = std::max(1, (int)(g.visible[i].count * scale));
+    }
+    std::sort(g.visible, g.visible + visibleCount, [](const GrassSystem::Chunk& a, const GrassSystem::Chunk& b) { return a.distance < b.distance; });
+
+    useProgram(g.program);
+    uploadViewUniforms(view);
+    setUniform1i("textureMode", 0);
+    setUniform1f("time", g_matchTime);
+    setUniform3f("wind", glm::vec3(0.6f, 0.35f, 1.8f));
+    bindTexture(GRASS_BLADE_UNIT, GL_TEXTURE_BUFFER, g.bladeTexture);
+    bindVertexArray(g.vao);
+    for (int i = 0; i < visibleCount; ++i) {
+        const GrassSystem::Chunk& chunk = g.visible[i];
+        int x = chunk.index % GRASS_CHUNKS_X, z = chunk.index / GRASS_CHUNKS_X;
+        setUniform2f("chunkCenter", -10.0f + (x + 0.5f) * GRASS_CHUNK_SIZE, -12.5f + (z + 0.5f) * GRASS_CHUNK_SIZE);
+        setUniform1i("chunkVariant", (chunk.index * 5 + 3) & 7);
+        setUniform1i("bladeCount", chunk.count);
+        setUniform1i("segments", chunk.segments);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 2 * chunk.segments + 1, chunk.count);
+        g_frameStats.drawCalls++;
+        g_frameStats.grassBlades += chunk.count;
+    }
+}
+
+void submitView(unsigned int shaderProgram, const SceneMeshes& meshes, const CameraView& view, const DrawList& list, const OcclusionBuffer* occlusion) {
+    ViewRect rect = viewRect(view);
+    glViewport(rect.x, rect.y, rect.width, rect.height);
+    setCapability(GL_SCISSOR_TEST, true);
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+    setDepthMask(true);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    setCapability(GL_DEPTH_TEST, true);
+    setCapability(GL_BLEND, true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    assignLights(view);
+
+    // Opacos na GPU quando dá (frustum no compute shader, oclusão do CPU como bits por objeto)
+    bool gpuOpaque = gpuDrivenActive();
+    if (gpuOpaque) {
+        cullGpuScene(meshes, view, list, occlusion);
+        useProgram(g_gpuScene.drawProgram);
+        uploadViewUniforms(view);
+        drawGpuScene();
+    }
+    drawGrass(view);
+
+    // Opacos (culling feito aqui; os translúcidos visíveis ficam guardados para o segundo passe)
+    Frustum frustum = frustumFromMatrix(view.projection * view.view);
+    FrameVector<const DrawItem*> translucent;
+    translucent.reserve(64 + g_translucentStress);
+    useProgram(shaderProgram);
+    uploadViewUniforms(view);
+    for (const DrawItem& item : list) {
+        if (gpuOpaque && item.color.a >= 1.0f) continue;
+        if (!sphereInFrustum(frustum, item.bounds)) { g_frameStats.culledItems++; continue; }
+        if (occlusion && !item.occluder) {
+            g_frameStats.occlusionTested++;
+            if (sphereOccluded(*occlusion, item.bounds)) { g_frameStats.occlusionRejected++; continue; }
+        }
+        if (item.color.a < 1.0f) { translucent.push_back(&item); continue; }
+        drawItem(meshes, item);
+    }
+    g_frameStats.translucentItems += (int)translucent.size();
+
+    // Translúcidos: teste de profundidade contra os opacos, sem escrever profundidade
+    setDepthMask(false);
+    if (g_transparencyMode == TRANSPARENCY_SORTED) {
+        // De trás para frente pela distância do centro do objeto à câmera
+        std::sort(translucent.begin(), translucent.end(), [&view](const DrawItem* a, const DrawItem* b) {
+            glm::vec3 da = glm::vec3(a->bounds) - view.position, db = glm::vec3(b->bounds) - view.position;
+            return glm::dot(da, da) > glm::dot(db, db);
+        });
+        for (const DrawItem* item : translucent) drawItem(meshes, *item);
+    } else if (!translucent.empty()) {
+        // Acumulação em qualquer ordem, depois resolve sobre a cor opaca do mesmo viewport
+        bindFramebuffer(g_oit.accumFBO);
+        const float accumClear[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const float weightClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, accumClear);
+        glClearBufferfv(GL_COLOR, 1, weightClear);
+        setBlendFunc(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        useProgram(g_oit.oitProgram);
+        uploadViewUniforms(view);
+        for (const DrawItem* item : translucent) drawItem(meshes, *item);
+
+        bindFramebuffer(g_oit.sceneFBO);
+        setCapability(GL_DEPTH_TEST, false);
+        setBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+        useProgram(g_oit.compositeProgram);
+        bindTexture(0, GL_TEXTURE_2D, g_oit.accumTexture);
+        bindTexture(1, GL_TEXTURE_2D, g_oit.weightTexture);
+        bindVertexArray(g_oit.emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        g_frameStats.drawCalls++;
+    }
+    drawParticles(view.view, view.projection);
+    setCapability(GL_SCISSOR_TEST, false);
+    g_frameStats.views++;
+}
+
+// Desenha um frame completo com o estado atual do jogo (não troca os buffers).
+// A cena vai para o framebuffer próprio (cor + profundidade compartilhada com o OIT), na resolução dinâmica,
+// e é ampliada para a janela no fim; o HUD é desenhado por cima na resolução da janela.
+// Com o pipeline a lista já vem montada pela thread da simulação (prebuilt) e o estado do jogo é o do snapshot dela.
+void renderScene(unsigned int shaderProgram, const SceneMeshes& meshes, const DrawList* prebuilt = nullptr) {
+    updateDynamicResolution();
+    g_frameStats.renderScale = g_dynRes.scale;
+    g_gpuScene.uploadedList = nullptr; // Listas novas neste frame
+    beginGpuCullStats();
+    beginSceneTiming();
+    bindFramebuffer(g_oit.sceneFBO);
+    glClearColor(0.1f, 0.2f, 0.1f, 1.0f);
+
+    // Atualiza a posição da câmera e a view matrix
+    updateCamera();
+    setAudioListener(g_cameraPos, g_cameraTarget);
+
+    pumpTextureStreaming();
+    if (g_textureReportRequest) { printTextureResidency(); g_textureReportRequest = false; }
+    updateLights();
+    updateParticles();
+
+    CameraView views[MAX_VIEWS];
+    int viewCount = setupViews(views);
+
+    DrawList localList;
+    const DrawList& drawList = prebuilt ? *prebuilt : localList;
+    if (prebuilt) {
+        if (g_occlusionCulling) beginOcclusion(views, viewCount, drawList);
+    } else {
+        localList.reserve(4096 + g_translucentStress);
+        buildSceneOccluders(localList);
+        if (g_occlusionCulling) beginOcclusion(views, viewCount, localList); // Roda no worker enquanto a cena é montada
+        buildSceneDynamic(localList);
+    }
+    recordReplaySnapshot();
+    if (g_occlusionCulling) waitOcclusion();
+
+    DrawList replayList;
+    for (int i = 0; i < viewCount; ++i) {
+        if (views[i].replay) {
+            // O replay é o único que precisa de outra cena: monta a partir do snapshot atrasado
+            GameSnapshot live = captureSnapshot();
+            applySnapshot(replaySnapshot());
+            replayList.reserve(drawList.size());
+            buildScene(replayList);
+            applySnapshot(live);
+            submitView(shaderProgram, meshes, views[i], replayList, g_occlusionCulling ? &g_occlusion.buffers[i] : nullptr);
+        } else {
+            submitView(shaderProgram, meshes, views[i], drawList, g_occlusionCulling ? &g_occlusion.buffers[i] : nullptr);
+        }
+    }
+
+    endGpuCullStats();
+    endSceneTiming();
+    upscaleToWindow();
+
+    renderHud();
+}
+
+
+// --- PIPELINE SIMULAÇÃO / RENDER ---
+// A simulação (updateGame + montagem da lista de desenho) roda na sua própria thread, um frame à frente do render.
+// Cada passo publica um FramePacket imutável num buffer triplo sem lock: a simulação escreve no slot 'back', o render
+// lê o 'front' e os dois trocam de slot com um exchange atômico no índice do meio, então um nunca segura o outro.
+// O estado do jogo é thread_local: o render aplica o snapshot do pacote (o mesmo caminho do replay) e só desenha.
+struct FramePacket {
+    GameSnapshot snapshot;
+    FrameArena arena;  // Memória de 'list'; zerada quando a simulação volta a escrever neste slot
+    DrawList list = DrawList(ArenaAllocator<DrawItem>(arena));
+    uint64_t tick = 0; // Passo de simulação que gerou o pacote
+    double inputTime = 0.0; // Entrada de chute mais antiga refletida neste pacote (0 = nenhuma)
+};
+
+struct SimulationPipeline {
+    static const int FRESH = 4;            // Bit no índice do meio: pacote publicado e ainda não lido
+    FramePacket packets[3];
+    std::atomic<int> middle{1};
+    int back = 0;                          // Só a thread da simulação
+    int front = 2; bool hasFront = false;  // Só a thread de render
+    std::thread thread;
+    bool running = false;
+    std::atomic<bool> quit{false};
+    std::mutex wakeMutex;                  // Só para a simulação dormir; a troca de pacotes não passa por ele
+    std::condition_variable wake;
+    std::mutex publishMutex;               // Só para o render dormir esperando um passo (PIPELINE_BOUNDED)
+    std::condition_variable published;
+    std::atomic<uint64_t> requestedTick{0}, publishedTick{0};
+    std::atomic<long long> pendingNs{0};   // Tempo de frame acumulado pelo render e ainda não simulado
+    std::atomic<float> simMs{0.0f};        // Duração do último passo (updateGame + montagem)
+    std::atomic<uint64_t> steps{0};
+    std::atomic<unsigned long long> heapAllocs{0}; // t_heapAllocCount da thread da simulação, após cada passo
+    bool arenasRegistered = false;
+    // Estatísticas da thread de render
+    uint64_t frames = 0, repeatedFrames = 0, waits = 0;
+    double waitMs = 0.0;
+};
+SimulationPipeline g_pipeline;
+
+void simulationThread() {
+    SimulationPipeline& p = g_pipeline;
+    frameArena().name = "simulacao";
+    uint64_t tick = 0;
+    double carriedInput = 0.0; // Entrada de um pacote que o render nunca pegou: vai no próximo
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(p.wakeMutex);
+            p.wake.wait(lock, [&] { return p.quit.load() || p.requestedTick.load() > tick; });
+        }
+        if (p.quit.load()) break;
+        // Frames pedidos enquanto o passo anterior rodava viram um passo só, com o tempo somado
+        tick = p.requestedTick.load(std::memory_order_acquire);
+        auto start = std::chrono::steady_clock::now();
+        updateGame(p.pendingNs.exchange(0) / 1.0e9f);
+
+        FramePacket& packet = p.packets[p.back];
+        packet.arena.reset();
+        packet.list = DrawList(ArenaAllocator<DrawItem>(packet.arena));
+        packet.list.reserve(4096 + g_translucentStress);
+        buildScene(packet.list);
+        packet.snapshot = captureSnapshot();
+        packet.tick = tick;
+        packet.inputTime = carriedInput > 0.0 ? carriedInput : g_kickInputTime;
+        int previous = p.middle.exchange(p.back | SimulationPipeline::FRESH, std::memory_order_acq_rel);
+        p.back = previous & ~SimulationPipeline::FRESH;
+        carriedInput = (previous & SimulationPipeline::FRESH) ? p.packets[p.back].inputTime : 0.0;
+        p.publishedTick.store(tick, std::memory_order_release);
+        { std::lock_guard<std::mutex> lock(p.publishMutex); } // Quem testou publishedTick sob o lock já dorme
+        p.published.notify_one();
+
+        frameArena().reset();
+        p.simMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        p.heapAllocs.store(t_heapAllocCount, std::memory_order_relaxed);
+        p.steps.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void startSimulationThread() {
+    SimulationPipeline& p = g_pipeline;
+    if (g_pipelineMode == PIPELINE_OFF || p.running) return;
+    if (!p.arenasRegistered) {
+        for (FramePacket& packet : p.packets) {
+            packet.arena.name = "pacote";
+            int slot = g_arenaCount.fetch_add(1);
+            if (slot < MAX_ARENAS) g_arenas[slot] = &packet.arena;
+        }
+        p.arenasRegistered = true;
+    }
+    p.middle = 1; p.back = 0; p.front = 2; p.hasFront = false;
+    p.requestedTick = 0; p.publishedTick = 0; p.pendingNs = 0; p.heapAllocs = 0;
+    p.quit = false;
+    p.thread = std::thread(simulationThread);
+    p.running = true;
+}
+
+void stopSimulationThread() {
+    SimulationPipeline& p = g_pipeline;
+    if (!p.running) return;
+    { std::lock_guard<std::mutex> lock(p.wakeMutex); p.quit = true; }
+    p.wake.notify_one();
+    p.thread.join();
+    p.running = false;
+}
+
+// Pede um passo de simulação com o tempo deste frame e devolve o pacote a desenhar.
+// PIPELINE_LATEST só espera pelo primeiro pacote; PIPELINE_BOUNDED espera o passo do frame anterior.
+const FramePacket& acquireFramePacket(float deltaTime) {
+    SimulationPipeline& p = g_pipeline;
+    p.pendingNs.fetch_add((long long)(deltaTime * 1.0e9));
+    uint64_t tick = p.requestedTick.fetch_add(1, std::memory_order_release) + 1;
+    { std::lock_guard<std::mutex> lock(p.wakeMutex); }
+    p.wake.notify_one();
+
+    uint64_t needed = (g_pipelineMode == PIPELINE_BOUNDED || !p.hasFront) ? std::max<uint64_t>(tick - 1, 1) : 0;
+    if (p.publishedTick.load(std::memory_order_acquire) < needed) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(p.publishMutex);
+        p.published.wait(lock, [&] { return p.publishedTick.load(std::memory_order_acquire) >= needed; });
+        p.waits++;
+        p.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    p.frames++;
+    if (p.middle.load(std::memory_order_relaxed) & SimulationPipeline::FRESH) {
+        p.front = p.middle.exchange(p.front, std::memory_order_acq_rel) & ~SimulationPipeline::FRESH;
+        p.hasFront = true;
+        noteInput(p.packets[p.front].inputTime);
+    } else {
+        p.repeatedFrames++; // A simulação não terminou um passo novo a tempo: desenha o mesmo de novo
+    }
+    return p.packets[p.front];
+}
+
+void printPipelineStats() {
+    const SimulationPipeline& p = g_pipeline;
+    if (p.frames == 0) return;
+    std::cout << "Pipeline (" << (g_pipelineMode == PIPELINE_BOUNDED ? "limitado" : "mais recente") << "): "
+              << p.frames << " frames, " << p.steps.load() << " passos de simulacao, "
+              << 100.0 * p.repeatedFrames / p.frames << "% frames repetidos, "
+              << p.waits << " esperas (" << p.waitMs << " ms)" << std::endl;
+}
+
+
+// --- BENCHMARK ---
+// Modo "--bench": roda cenários roteirizados com semente e passo de tempo fixos,
+// mede cada frame e grava os resultados em JSON (opcionalmente comparando com uma baseline).
+struct BenchOptions {
+    bool enabled = false;
+    std::string outputPath = "bench_results.json";
+    std::string baselinePath;          // JSON de uma execução anterior para comparação
+    std::string only;                  // Roda apenas o cenário com esse nome
+    double regressThresholdPct = 10.0; // Piora máxima tolerada no p50 antes de falhar
+    unsigned int seed = 1234;
+};
+BenchOptions g_benchOptions;
+bool g_printArenaStats = false; // --arena-stats: imprime o pico de uso das arenas de frame ao sair
+
+const float BENCH_DT = 1.0f / 60.0f;
+
+struct BenchScenario {
+    const char* name;
+    int warmupFrames;
+    int maxFrames;
+    void (*setup)();
+    void (*step)(int frame); // Chamado antes de cada updateGame (roteiro do cenário)
+    bool (*done)();          // Termina o cenário antes de maxFrames (pode ser nullptr)
+    void (*teardown)() = nullptr; // Desfaz o que resetMatch não cobre
+};
+
+struct BenchResult {
+    std::string name;
+    int frames = 0;
+    bool gpuDriven = false;            // Opacos pelo caminho da GPU neste cenário (suporte + ajuste efetivo)
+    std::vector<double> frameMs, cpuMs, gpuMs;
+    double drawCallsMean = 0.0; int drawCallsMax = 0;
+    double peakMemoryMB = 0.0;
+    unsigned long long heapAllocs = 0; // Alocações no heap em regime, render + simulação (deve ser 0)
+    size_t arenaHighWater = 0;
+    double textureUploadMaxKB = 0.0;   // Maior upload de textura num frame
+    double occludedPct = 0.0;          // % dos itens testados descartados pela oclusão
+    double renderScaleMean = 1.0, renderScaleMin = 1.0; // Resolução dinâmica nos frames medidos
+    double stateIssuedMean = 0.0, stateSkippedMean = 0.0;  // Cache de estado GL: chamadas enviadas / evitadas por frame
+    std::vector<double> latencyMs;     // Entrada -> GPU terminou o frame (só nos frames com entrada)
+    double particlesMean = 0.0;        // Partículas vivas por frame
+    double grassBladesMean = 0.0; int grassBladesMax = 0; // Tufos de grama por frame (somando as câmeras)
+    double gpuMemoryMB = 0.0;          // Maior total de objetos GL vivos no pool nos frames medidos
+    double lightsDroppedMean = 0.0; int truncatedClustersMax = 0; // Luzes cortadas pelo limite por cluster
+};
+
+// Sequência fixa de escolhas do batedor (1 = meio, 2 = direita, 3 = esquerda)
+const int g_benchKickScript[6] = {1, 2, 3, 3, 2, 1};
+
+void benchOrbitStep(int frame) {
+    g_cameraYaw = glm::radians(45.0f) + frame * (2.0f * PI / 360.0f);
+}
+
+const BenchScenario g_benchScenarios[] = {
+    // Disputa completa de 6 cobranças, do primeiro chute até o fim de jogo
+    {"shootout", 30, 20000, [] {},
+        [](int) { if (g_gameState == STATE_READY) requestKick(g_benchKickScript[g_currentKick % 6]); },
+        [] { return g_gameState == STATE_GAMEOVER; }},
+    // Comemoração de gol com a torcida do Time 1 pulando e a rede balançando
+    {"goal_celebration", 30, 600,
+        [] {
+            g_gameState = STATE_GOAL; g_sim.goalRecorded = true; g_currentKicker = TEAM_1;
+            g_ballPosition = glm::vec3(0.0f, g_ballRadius, g_goalLineZ - 0.05f);
+        },
+        [](int frame) {
+            g_sim.resetTimer = 100.0f; // Mantém o estado de gol durante todo o cenário
+            if (frame % 60 == 0) g_netAnimationTimer = 0.5f;
+        },
+        nullptr},
+    // Volta completa da câmera orbital, variando também a altura
+    {"orbit_sweep", 30, 720, [] {},
+        [](int frame) {
+            g_cameraYaw = glm::radians(45.0f) + frame * (2.0f * PI / 720.0f);
+            g_cameraPitch = glm::radians(20.0f) + glm::radians(25.0f) * sin(frame * (2.0f * PI / 720.0f));
+        },
+        nullptr},
+    // Torcida multiplicada sobre o layout de drawCrowd
+    {"crowd_1x",   30, 300, [] { g_crowdScale = 1;   }, nullptr, nullptr},
+    {"crowd_10x",  30, 300, [] { g_crowdScale = 10;  }, nullptr, nullptr},
+    {"crowd_100x", 10, 120, [] { g_crowdScale = 100; }, nullptr, nullptr},
+    // O mesmo com a simulação e a montagem na thread do pipeline (modo limitado, para o render não andar sozinho)
+    {"crowd_100x_pipelined", 10, 120, [] { g_crowdScale = 100; g_pipelineMode = PIPELINE_BOUNDED; }, nullptr, nullptr},
+    // Cinco câmeras simultâneas durante uma cobrança (mesma cena, culling/submissão por câmera)
+    {"multiview_5", 30, 600, [] { g_multiView = true; },
+        [](int) { if (g_gameState == STATE_READY) requestKick(2); },
+        nullptr},
+    // Os mesmos com os opacos submetidos pelo CPU, um draw por item (referência para o multi-draw indireto)
+    {"crowd_100x_cpu_submit", 10, 120, [] { g_crowdScale = 100; g_gpuDriven = false; }, nullptr, nullptr},
+    {"multiview_5_cpu_submit", 30, 600, [] { g_multiView = true; g_gpuDriven = false; },
+        [](int) { if (g_gameState == STATE_READY) requestKick(2); },
+        nullptr},
+    // Transparência: OIT contra ordenação por câmera, só a rede e com cortinas de painéis translúcidos.
+    // A câmera gira para a ordem de trás para frente mudar a cada frame.
+    {"translucent_sorted_net",  30, 360, [] { g_transparencyMode = TRANSPARENCY_SORTED; }, benchOrbitStep, nullptr},
+    {"translucent_oit_net",     30, 360, [] { g_transparencyMode = TRANSPARENCY_OIT; }, benchOrbitStep, nullptr},
+    {"translucent_sorted_256",  30, 360, [] { g_transparencyMode = TRANSPARENCY_SORTED; g_translucentStress = 256; }, benchOrbitStep, nullptr},
+    {"translucent_oit_256",     30, 360, [] { g_transparencyMode = TRANSPARENCY_OIT; g_translucentStress = 256; }, benchOrbitStep, nullptr},
+    {"translucent_sorted_4096", 10, 120, [] { g_transparencyMode = TRANSPARENCY_SORTED; g_translucentStress = 4096; }, benchOrbitStep, nullptr},
+    {"translucent_oit_4096",    10, 120, [] { g_transparencyMode = TRANSPARENCY_OIT; g_translucentStress = 4096; }, benchOrbitStep, nullptr},
+    // Luzes: refletores + placar (~16-22) e sinalizadores extras; o custo deve ficar quase plano
+    {"lights_base",     30, 300, [] { g_extraLights = 0; },    benchOrbitStep, nullptr},
+    {"lights_plus_128", 30, 300, [] { g_extraLights = 128; },  benchOrbitStep, nullptr},
+    {"lights_plus_512", 30, 300, [] { g_extraLights = 512; },  benchOrbitStep, nullptr},
+    {"lights_plus_1000", 30, 300, [] { g_extraLights = 1000; }, benchOrbitStep, nullptr},
+    // Oclusão: câmera baixa girando em volta do campo com a torcida 10x, com e sem o Z hierárquico
+    {"occlusion_low_orbit_on",  30, 360, [] { g_crowdScale = 10; g_cameraPitch = glm::radians(6.0f); }, benchOrbitStep, nullptr},
+    {"occlusion_low_orbit_off", 30, 360, [] { g_crowdScale = 10; g_cameraPitch = glm::radians(6.0f); g_occlusionCulling = false; }, benchOrbitStep, nullptr},
+    // Recarrega todas as texturas geradas 4x maiores (~120 MiB com mips) e mede os frames durante o streaming
+    {"texture_stream_4x", 0, 300, [] { restartTextureStreaming(4); }, benchOrbitStep, nullptr,
+        [] { printTextureResidency(); restartTextureStreaming(1); }},
+    // Latência entrada -> tela com uma entrada de câmera por frame, GPU carregada: fila livre contra fila de 1 frame
+    {"latency_crowd_100x",     10, 240, [] { g_crowdScale = 100; }, [](int frame) { benchOrbitStep(frame); noteInput(glfwGetTime()); }, nullptr},
+    {"latency_crowd_100x_low", 10, 240, [] { g_crowdScale = 100; g_lowLatency = true; }, [](int frame) { benchOrbitStep(frame); noteInput(glfwGetTime()); }, nullptr},
+    // Torcida 100x com a resolução dinâmica ligada: o controlador deve segurar o tempo de GPU perto do alvo
+    {"dynres_crowd_100x", 30, 300, [] { g_crowdScale = 100; g_dynamicResolution = true; g_dynRes.gpuMs = 0.0f; g_dynRes.cooldown = 0; }, benchOrbitStep, nullptr},
+    // ~100k partículas de confete vivas (o aquecimento cobre o primeiro ciclo de vida), no compute shader e no CPU
+    {"particles_100k", 360, 600, [] { g_particleStress = 100000; }, benchOrbitStep, nullptr},
+    {"particles_100k_cpu", 360, 600, [] { g_particleStress = 100000; g_particlesCpu = true; }, benchOrbitStep, nullptr},
+    // Grama no tile inteiro com a câmera no zoom e na inclinação mínimos (pior caso: tudo perto) e com cinco câmeras
+    {"grass_dense_close", 30, 360, [] { g_grassDensity = 1.0f; g_cameraRadius = 3.0f; g_cameraPitch = glm::radians(5.0f); }, benchOrbitStep, nullptr},
+    {"grass_dense_multiview_5", 30, 360, [] { g_grassDensity = 1.0f; g_multiView = true; }, benchOrbitStep, nullptr},
+};
+
+double peakMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes no macOS
+#else
+    return usage.ru_maxrss / 1024.0;            // KiB no Linux
+#endif
+#endif
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+    return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+double mean(const std::vector<double>& values) {
+    if (values.empty()) return 0.0;
+    double sum = 0.0; for (double v : values) sum += v;
+    return sum / values.size();
+}
+
+void writeStatsJson(std::ostream& out, const char* key, const std::vector<double>& values) {
+    out << "      \"" << key << "\": {\"mean\": " << mean(values) << ", \"p50\": " << percentile(values, 50)
+        << ", \"p90\": " << percentile(values, 90) << ", \"p95\": " << percentile(values, 95)
+        << ", \"p99\": " << percentile(values, 99) << ", \"max\": " << percentile(values, 100) << "}";
+}
+
+// Procura "key": <número> em json a partir de 'from' (suficiente para o formato que nós mesmos gravamos).
+bool findJsonNumber(const std::string& json, size_t from, size_t to, const std::string& key, double& out) {
+    size_t pos = json.find("\"" + key + "\"", from);
+    if (pos == std::string::npos || pos >= to) return false;
+    pos = json.find(':', pos);
+    if (pos == std::string::npos) return false;
+    out = std::strtod(json.c_str() + pos + 1, nullptr);
+    return true;
+}
+
+// Compara os resultados com a baseline; retorna false se algum p50 piorou além do limite.
+bool compareWithBaseline(const std::vector<BenchResult>& results, const std::string& baselinePath, double thresholdPct, std::ostream& json) {
+    std::ifstream file(baselinePath);
+    if (!file) { std::cout << "Baseline nao encontrada: " << baselinePath << std::endl; return true; }
+    std::stringstream buffer; buffer << file.rdbuf();
+    std::string baseline = buffer.str();
+
+    bool ok = true;
+    std::cout << "\n=== Comparacao com " << baselinePath << " ===\n";
+    json << ",\n  \"comparison\": [\n";
+    bool first = true;
+    for (const BenchResult& r : results) {
+        size_t begin = baseline.find("\"name\": \"" + r.name + "\"");
+        if (begin == std::string::npos) continue;
+        size_t end = baseline.find("\"name\": \"", begin + 1);
+        if (end == std::string::npos) end = baseline.size();
+
+        double baseP50 = 0.0, baseP99 = 0.0, baseGpu = 0.0, baseDraws = 0.0;
+        size_t frameKey = baseline.find("\"frame_ms\"", begin);
+        size_t gpuKey = baseline.find("\"gpu_ms\"", begin);
+        findJsonNumber(baseline, frameKey, end, "p50", baseP50);
+        findJsonNumber(baseline, frameKey, end, "p99", baseP99);
+        findJsonNumber(baseline, gpuKey, end, "mean", baseGpu);
+        findJsonNumber(baseline, begin, end, "draw_calls_mean", baseDraws);
+
+        auto delta = [](double now, double before) { return before > 0.0 ? (now - before) / before * 100.0 : 0.0; };
+        double p50 = percentile(r.frameMs, 50), p99 = percentile(r.frameMs, 99);
+        double dP50 = delta(p50, baseP50), dP99 = delta(p99, baseP99), dGpu = delta(mean(r.gpuMs), baseGpu), dDraws = delta(r.drawCallsMean, baseDraws);
+        bool regressed = dP50 > thresholdPct;
+        if (regressed) ok = false;
+
+        std::cout << "  " << std::left << std::setw(18) << r.name << std::right
+                  << " p50 " << std::setw(8) << p50 << " ms (" << std::showpos << dP50 << "%)"
+                  << "  p99 " << std::noshowpos << std::setw(8) << p99 << " ms (" << std::showpos << dP99 << "%)"
+                  << "  gpu " << dGpu << "%  draws " << dDraws << "%" << std::noshowpos
+                  << (regressed ? "  <-- REGRESSAO" : "") << "\n";
+
+        json << (first ? "" : ",\n") << "    {\"name\": \"" << r.name << "\", \"frame_p50_delta_pct\": " << dP50
+             << ", \"frame_p99_delta_pct\": " << dP99 << ", \"gpu_mean_delta_pct\": " << dGpu
+             << ", \"draw_calls_delta_pct\": " << dDraws << ", \"regressed\": " << (regressed ? "true" : "false") << "}";
+        first = false;
+    }
+    json << "\n  ]";
+    std::cout << std::endl;
+    return ok;
+}
+
+struct MicroResult {
+    std::string name;
+    double nsPerOp;
+};
+
+// Microbenchmark das transformações: compõe 'rigs' bases com as partes de um rig de jogador
+// pelo caminho antigo (glm::mat4) e pelo Affine3x4 (uma a uma e em lote).
+std::vector<MicroResult> runTransformMicrobench() {
+    typedef std::chrono::steady_clock Clock;
+    const int RIGS = 2048, PASSES = 40;
+    PlayerRig rig;
+    buildPlayerRig(STATE_RUNNING_UP, 0.37f, TEAM_1, rig);
+
+    std::vector<glm::mat4> baseMats(RIGS), partMats(rig.count), outMats((size_t)RIGS * rig.count);
+    std::vector<Affine3x4> baseAff(RIGS), outAff((size_t)RIGS * rig.count);
+    for (int r = 0; r < RIGS; ++r) {
+        baseAff[r] = playerBaseTransform(glm::vec3(-11.0f - r % 4, 0.75f, -12.0f + (r / 4) * 0.05f));
+        baseMats[r] = affineToMat4(baseAff[r]);
+    }
+    for (int p = 0; p < rig.count; ++p) partMats[p] = affineToMat4(rig.transforms[p]);
+
+    std::vector<MicroResult> results;
+    double ops = (double)RIGS * rig.count * PASSES;
+    volatile float sink = 0.0f; // Impede o compilador de descartar os resultados
+
+    Clock::time_point t0 = Clock::now();
+    for (int pass = 0; pass < PASSES; ++pass)
+        for (int r = 0; r < RIGS; ++r)
+            for (int p = 0; p < rig.count; ++p) outMats[(size_t)r * rig.count + p] = baseMats[r] * partMats[p];
+    Clock::time_point t1 = Clock::now();
+    sink = sink + outMats[RIGS / 2][3][0];
+    results.push_back({"compose_glm_mat4", std::chrono::duration<double, std::nano>(t1 - t0).count() / ops});
+
+    t0 = Clock::now();
+    for (int pass = 0; pass < PASSES; ++pass)
+        for (int r = 0; r < RIGS; ++r)
+            for (int p = 0; p < rig.count; ++p) outAff[(size_t)r * rig.count + p] = affineMul(baseAff[r], rig.transforms[p]);
+    t1 = Clock::now();
+    sink = sink + outAff[RIGS / 2].m[0][3];
+    results.push_back({"compose_affine", std::chrono::duration<double, std::nano>(t1 - t0).count() / ops});
+
+    t0 = Clock::now();
+    for (int pass = 0; pass < PASSES; ++pass) affineComposeRigs(baseAff.data(), RIGS, rig.transforms, rig.count, outAff.data());
+    t1 = Clock::now();
+    sink = sink + outAff[RIGS / 2].m[0][3];
+    results.push_back({"compose_affine_batch", std::chrono::duration<double, std::nano>(t1 - t0).count() / ops});
+
+    // Montagem completa de um rig (cadeia de translate/rotate/scale da hierarquia)
+    t0 = Clock::now();
+    for (int pass = 0; pass < RIGS; ++pass) { buildPlayerRig(STATE_RUNNING_UP, pass * 0.01f, TEAM_1, rig); sink = sink + rig.transforms[5].m[1][3]; }
+    t1 = Clock::now();
+    results.push_back({"build_player_rig_affine", std::chrono::duration<double, std::nano>(t1 - t0).count() / RIGS});
+
+    std::cout << "[bench] transforms:";
+    for (const MicroResult& m : results) std::cout << "  " << m.name << " " << m.nsPerOp << " ns";
+    std::cout << std::endl;
+    return results;
+}
+
+// Microbenchmark do mixer, sem a thread nem a saída: 48 vozes espaciais + torcida, câmera girando
+std::vector<MicroResult> runAudioMicrobench() {
+    typedef std::chrono::steady_clock Clock;
+    const int VOICES = 48, BUFFERS = 2000;
+    static AudioMixer mixer; // Grande demais para a pilha
+    synthesizeSounds(mixer);
+    const SoundId loops[4] = {SOUND_KICK, SOUND_POST, SOUND_NET, SOUND_GOAL_ROAR};
+    for (int i = 1; i <= VOICES; ++i) {
+        AudioVoice& v = mixer.voices[i];
+        const std::vector<float>& sound = mixer.sounds[loops[i % 4]];
+        v.samples = sound.data(); v.length = (int)sound.size(); v.position = (i * 997) % v.length;
+        v.loop = true; v.spatial = true; v.gain = 0.5f;
+        v.source = glm::vec3(-10.0f + (i % 8) * 3.0f, 1.0f, -12.0f + (i / 8) * 4.0f);
+    }
+
+    Clock::time_point t0 = Clock::now();
+    for (int b = 0; b < BUFFERS; ++b) {
+        float angle = b * 0.01f;
+        mixer.listener = glm::vec3(20.0f * std::cos(angle), 6.0f, 20.0f * std::sin(angle));
+        mixer.listenerRight = glm::normalize(glm::cross(-mixer.listener, glm::vec3(0.0f, 1.0f, 0.0f)));
+        mixAudioBuffer(mixer);
+    }
+    Clock::time_point t1 = Clock::now();
+
+    std::vector<MicroResult> results;
+    results.push_back({"audio_mix_48_voices_per_buffer", std::chrono::duration<double, std::nano>(t1 - t0).count() / BUFFERS});
+    double bufferNs = AUDIO_BUFFER_FRAMES * 1.0e9 / AUDIO_RATE;
+    std::cout << "[bench] audio: " << results[0].nsPerOp / 1000.0 << " us por buffer de " << AUDIO_BUFFER_FRAMES
+              << " quadros (" << 100.0 * results[0].nsPerOp / bufferNs << "% do tempo real)" << std::endl;
+    return results;
+}
+
+int runBenchmark(GLFWwindow* window, unsigned int shaderProgram, const SceneMeshes& meshes) {
+    typedef std::chrono::steady_clock Clock;
+    g_latency.swapInterval = 0;
+    glfwSwapInterval(0); // Mede o custo real, sem esperar o vsync
+
+    // Ring de queries de tempo da GPU: lê o resultado alguns frames depois para não travar o pipeline
+    const int QUERY_COUNT = 4;
+    unsigned int gpuQueries[QUERY_COUNT];
+    bool queryPending[QUERY_COUNT] = {false};
+    bool queryMeasured[QUERY_COUNT] = {false};
+    glGenQueries(QUERY_COUNT, gpuQueries);
+
+    std::vector<MicroResult> microResults;
+    if (g_benchOptions.only.empty() || g_benchOptions.only == "transforms") microResults = runTransformMicrobench();
+    if (g_benchOptions.only.empty() || g_benchOptions.only == "audio") {
+        std::vector<MicroResult> audio = runAudioMicrobench();
+        microResults.insert(microResults.end(), audio.begin(), audio.end());
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchScenario& scenario : g_benchScenarios) {
+        if (!g_benchOptions.only.empty() && g_benchOptions.only != scenario.name) continue;
+        std::cout << "[bench] " << scenario.name << "..." << std::endl;
+
+        resetMatch();
+        resetBenchSettings();
+        g_randomEngine.seed(g_benchOptions.seed);
+        scenario.setup();
+        startSimulationThread(); // Só nos cenários que ligam o pipeline
+
+        BenchResult result;
+        result.name = scenario.name;
+        result.gpuDriven = gpuDrivenActive();
+        result.frameMs.reserve(scenario.maxFrames); result.cpuMs.reserve(scenario.maxFrames); result.gpuMs.reserve(scenario.maxFrames + QUERY_COUNT);
+        long long drawCallSum = 0, occlusionTested = 0, occlusionRejected = 0;
+        double renderScaleSum = 0.0;
+        long long stateIssuedSum = 0, stateSkippedSum = 0, particleSum = 0, grassSum = 0, lightsDroppedSum = 0;
+        unsigned long long firstLatencySample = g_latency.samples;
+        unsigned long long simAllocsBefore = 0; // Contador da thread da simulação no início do regime
+        Clock::time_point previousFrameEnd = Clock::now();
+
+        auto collectQuery = [&](int slot) {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(gpuQueries[slot], GL_QUERY_RESULT, &elapsedNs);
+            if (queryMeasured[slot]) result.gpuMs.push_back(elapsedNs / 1.0e6);
+            queryPending[slot] = false;
+        };
+
+        for (int frame = 0; frame < scenario.warmupFrames + scenario.maxFrames && !glfwWindowShouldClose(window); ++frame) {
+            bool measured = frame >= scenario.warmupFrames;
+            unsigned long long allocsBefore = t_heapAllocCount;
+            beginFrameLatency();
+            if (frame == scenario.warmupFrames) {
+                firstLatencySample = g_latency.samples;
+                simAllocsBefore = g_pipeline.heapAllocs.load(std::memory_order_relaxed);
+            }
+            Clock::time_point frameStart = Clock::now();
+            glfwPollEvents();
+
+            if (scenario.step) scenario.step(frame);
+            const DrawList* prebuilt = nullptr;
+            if (g_pipeline.running) {
+                const FramePacket& packet = acquireFramePacket(BENCH_DT);
+                applySnapshot(packet.snapshot);
+                prebuilt = &packet.list;
+            } else {
+                updateGame(BENCH_DT);
+                noteInput(g_kickInputTime);
+            }
+
+            int slot = frame % QUERY_COUNT;
+            if (queryPending[slot]) collectQuery(slot);
+            g_frameStats = FrameStats();
+            glBeginQuery(GL_TIME_ELAPSED, gpuQueries[slot]);
+            renderScene(shaderProgram, meshes, prebuilt);
+            glEndQuery(GL_TIME_ELAPSED);
+            queryPending[slot] = true; queryMeasured[slot] = measured;
+            Clock::time_point submitEnd = Clock::now();
+
+            double submitted = glfwGetTime();
+            glfwSwapBuffers(window);
+            endFrameLatency(submitted);
+            endFrameGpuResources();
+            frameArena().reset();
+            Clock::time_point frameEnd = Clock::now();
+            unsigned long long frameAllocs = t_heapAllocCount - allocsBefore;
+
+            if (measured) {
+                result.heapAllocs += frameAllocs;
+                result.frameMs.push_back(std::chrono::duration<double, std::milli>(frameEnd - previousFrameEnd).count());
+                result.cpuMs.push_back(std::chrono::duration<double, std::milli>(submitEnd - frameStart).count());
+                drawCallSum += g_frameStats.drawCalls;
+                result.drawCallsMax = std::max(result.drawCallsMax, g_frameStats.drawCalls);
+                result.textureUploadMaxKB = std::max(result.textureUploadMaxKB, g_frameStats.textureUploadBytes / 1024.0);
+                occlusionTested += g_frameStats.occlusionTested; occlusionRejected += g_frameStats.occlusionRejected;
+                renderScaleSum += g_frameStats.renderScale;
+                stateIssuedSum += g_frameStats.stateIssued; stateSkippedSum += g_frameStats.stateSkipped;
+                particleSum += g_frameStats.particles;
+                grassSum += g_frameStats.grassBlades;
+                result.grassBladesMax = std::max(result.grassBladesMax, g_frameStats.grassBlades);
+                lightsDroppedSum += g_frameStats.lightsDropped;
+                result.truncatedClustersMax = std::max(result.truncatedClustersMax, g_frameStats.truncatedClusters);
+                result.gpuMemoryMB = std::max(result.gpuMemoryMB, g_gpuResources.totalBytes / (1024.0 * 1024.0));
+                result.renderScaleMin = std::min(result.renderScaleMin, (double)g_frameStats.renderScale);
+                result.frames++;
+            }
+            previousFrameEnd = frameEnd;
+
+            if (measured && scenario.done && scenario.done()) break;
+        }
+        for (int slot = 0; slot < QUERY_COUNT; ++slot) if (queryPending[slot]) collectQuery(slot);
+        flushLatency();
+        result.latencyMs = latencySamples(firstLatencySample, g_latency.samples);
+        if (g_pipeline.running) result.heapAllocs += g_pipeline.heapAllocs.load(std::memory_order_relaxed) - simAllocsBefore;
+        stopSimulationThread();
+        if (scenario.teardown) scenario.teardown();
+
+        result.drawCallsMean = result.frames > 0 ? (double)drawCallSum / result.frames : 0.0;
+        result.occludedPct = occlusionTested > 0 ? 100.0 * occlusionRejected / occlusionTested : 0.0;
+        result.renderScaleMean = result.frames > 0 ? renderScaleSum / result.frames : 1.0;
+        result.stateIssuedMean = result.frames > 0 ? (double)stateIssuedSum / result.frames : 0.0;
+        result.stateSkippedMean = result.frames > 0 ? (double)stateSkippedSum / result.frames : 0.0;
+        result.particlesMean = result.frames > 0 ? (double)particleSum / result.frames : 0.0;
+        result.grassBladesMean = result.frames > 0 ? (double)grassSum / result.frames : 0.0;
+        result.lightsDroppedMean = result.frames > 0 ? (double)lightsDroppedSum / result.frames : 0.0;
+        result.peakMemoryMB = peakMemoryMB();
+        result.arenaHighWater = frameArena().highWater;
+        results.push_back(result);
+    }
+    glDeleteQueries(QUERY_COUNT, gpuQueries);
+
+    // --- Saída em JSON ---
+    std::ofstream json(g_benchOptions.outputPath);
+    json << std::fixed << std::setprecision(4);
+    json << "{\n  \"version\": 1,\n  \"seed\": " << g_benchOptions.seed << ",\n  \"fixed_dt\": " << BENCH_DT
+         << ",\n  \"renderer\": \"" << (const char*)glGetString(GL_RENDERER) << "\",\n  \"gpu_driven_supported\": " << (g_gpuScene.supported ? "true" : "false")
+         << ",\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        json << "    {\n      \"name\": \"" << r.name << "\",\n      \"frames\": " << r.frames
+             << ",\n      \"gpu_driven\": " << (r.gpuDriven ? "true" : "false") << ",\n";
+        writeStatsJson(json, "frame_ms", r.frameMs); json << ",\n";
+        writeStatsJson(json, "cpu_ms", r.cpuMs); json << ",\n";
+        writeStatsJson(json, "gpu_ms", r.gpuMs); json << ",\n";
+        writeStatsJson(json, "input_latency_ms", r.latencyMs); json << ",\n";
+        json << "      \"draw_calls_mean\": " << r.drawCallsMean << ",\n      \"draw_calls_max\": " << r.drawCallsMax
+             << ",\n      \"peak_memory_mb\": " << r.peakMemoryMB << ",\n      \"heap_allocs_steady_state\": " << r.heapAllocs
+             << ",\n      \"arena_high_water_kb\": " << r.arenaHighWater / 1024.0
+             << ",\n      \"texture_upload_max_kb\": " << r.textureUploadMaxKB
+             << ",\n      \"occluded_pct\": " << r.occludedPct
+             << ",\n      \"render_scale_mean\": " << r.renderScaleMean << ",\n      \"render_scale_min\": " << r.renderScaleMin
+             << ",\n      \"state_calls_issued_mean\": " << r.stateIssuedMean << ",\n      \"state_calls_skipped_mean\": " << r.stateSkippedMean
+             << ",\n      \"particles_mean\": " << r.particlesMean
+             << ",\n      \"grass_blades_mean\": " << r.grassBladesMean << ",\n      \"grass_blades_max\": " << r.grassBladesMax
+             << ",\n      \"gpu_memory_mb\": " << r.gpuMemoryMB
+             << ",\n      \"lights_dropped_mean\": " << r.lightsDroppedMean << ",\n      \"truncated_clusters_max\": " << r.truncatedClustersMax << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ],\n  \"microbenchmarks\": [\n";
+    for (size_t i = 0; i < microResults.size(); ++i) {
+        json << "    {\"name\": \"" << microResults[i].name << "\", \"ns_per_op\": " << microResults[i].nsPerOp << "}"
+             << (i + 1 < microResults.size() ? "," : "") << "\n";
+    }
+    json << "  ]";
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "\n=== Resultados (ms) ===\n";
+    for (const BenchResult& r : results) {
+        std::cout << "  " << std::left << std::setw(18) << r.name << std::right << " frames " << std::setw(6) << r.frames
+                  << "  p50 " << std::setw(8) << percentile(r.frameMs, 50) << "  p99 " << std::setw(8) << percentile(r.frameMs, 99)
+                  << "  cpu " << std::setw(8) << mean(r.cpuMs) << "  gpu " << std::setw(8) << mean(r.gpuMs)
+                  << "  draws " << std::setw(8) << r.drawCallsMean << "  ocultos " << std::setw(5) << r.occludedPct << "%  res " << std::setw(5) << r.renderScaleMean * 100.0 << "%  mem " << r.peakMemoryMB << " MB\n";
+    }
+
+    // Verificação de alocação: o loop em regime não pode tocar no heap
+    bool ok = true;
+    for (const BenchResult& r : results) {
+        if (r.heapAllocs > 0) {
+            std::cout << "  FALHA: " << r.name << " fez " << r.heapAllocs << " alocacoes no heap em " << r.frames << " frames em regime\n";
+            ok = false;
+        }
+        // Não reprova, mas o custo de iluminação medido deixou luzes de fora
+        if (r.lightsDroppedMean > 0.0)
+            std::cout << "  AVISO: " << r.name << " descartou em media " << r.lightsDroppedMean << " pares luz/cluster por frame (ate "
+                      << r.truncatedClustersMax << " clusters cheios num frame); iluminacao truncada\n";
+    }
+    if (!g_benchOptions.baselinePath.empty() && !compareWithBaseline(results, g_benchOptions.baselinePath, g_benchOptions.regressThresholdPct, json)) ok = false;
+    json << "\n}\n";
+    std::cout << "Resultados gravados em " << g_benchOptions.outputPath << std::endl;
+    return ok ? 0 : 1;
+}
+
+void parseCommandLine(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        int used = applyRenderOption(arg, hasValue ? argv[i + 1] : nullptr);
+        if (used > 0) {
+            g_renderOptionArgs.push_back(std::make_pair(arg, std::string(used == 2 ? argv[i + 1] : "")));
+            i += used - 1;
+            continue;
+        }
+        if (arg == "--bench") {
+            g_benchOptions.enabled = true;
+            if (hasValue && argv[i + 1][0] != '-') g_benchOptions.outputPath = argv[++i];
+        }
+        else if (arg == "--baseline" && hasValue) g_benchOptions.baselinePath = argv[++i];
+        else if (arg == "--bench-only" && hasValue) g_benchOptions.only = argv[++i];
+        else if (arg == "--bench-seed" && hasValue) g_benchOptions.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--no-hud") g_showHud = false;
+        else if (arg == "--max-queued-frames" && hasValue) g_latency.maxQueuedFrames = std::atoi(argv[++i]);
+        else if (arg == "--swap-interval" && hasValue) g_latency.swapInterval = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--no-audio") g_audio.outputMode = AUDIO_OUTPUT_OFF;
+        else if (arg == "--no-particles") g_particlesEnabled = false;
+        else if (arg == "--audio-wav" && hasValue) { g_audio.outputMode = AUDIO_OUTPUT_WAV; g_audio.wavPath = argv[++i]; }
+        else if (arg == "--dynres-target" && hasValue) g_dynRes.targetMs = (float)std::strtod(argv[++i], nullptr);
+        else if (arg == "--dynres-min" && hasValue) g_dynRes.minScale = glm::clamp((float)std::strtod(argv[++i], nullptr), 0.25f, 1.0f);
+        else if (arg == "--dynres-max" && hasValue) g_dynRes.maxScale = glm::clamp((float)std::strtod(argv[++i], nullptr), 0.25f, 1.0f);
+        else if (arg == "--dynres-hysteresis" && hasValue) g_dynRes.hysteresisPct = (float)std::strtod(argv[++i], nullptr);
+        else if (arg == "--font" && hasValue) g_hudFontPath = argv[++i];
+        else if (arg == "--gpu-budget" && hasValue) g_gpuResources.budgetBytes = (size_t)std::max(1, std::atoi(argv[++i])) << 20;
+        else if (arg == "--upload-budget" && hasValue) g_textures.uploadBudget = (size_t)std::max(1, std::atoi(argv[++i])) * 1024;
+        else if (arg == "--lights" && hasValue) g_extraLights = std::min(std::atoi(argv[++i]), MAX_LIGHTS);
+        else if (arg == "--threads" && hasValue) g_workerThreads = std::atoi(argv[++i]);
+        else if (arg == "--arena-stats") g_printArenaStats = true;
+        else if (arg == "--gl-validate") g_glState.validate = true;
+        else if (arg == "--event-log" && hasValue) g_eventLogPath = argv[++i];
+        else if (arg == "--regress-threshold" && hasValue) g_benchOptions.regressThresholdPct = std::strtod(argv[++i], nullptr);
+        else std::cout << "Opcao ignorada: " << arg << std::endl;
+    }
+}
+
+
+// --- PROGRAMA PRINCIPAL ---
+int main(int argc, char** argv) {
+    parseCommandLine(argc, argv);
+    startEventLog();
+    startAudio();
+    frameArena().name = "principal";
+    int workerThreads = g_workerThreads >= 0 ? g_workerThreads : (int)std::thread::hardware_concurrency() - 1;
+    g_threadPool.start(std::max(0, workerThreads));
+
+    // --- INICIALIZAÇÃO ---
+    assert(glfwInit() == GLFW_TRUE);
+    // 4.5 para a renderização na GPU; sem ela, o 3.3 de sempre
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Disputa de Penaltis 3D (v5 Animado)", nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Disputa de Penaltis 3D (v5 Animado)", nullptr, nullptr);
+    }
+    assert(window);
+    glfwMakeContextCurrent(window);
+    glfwSetKeyCallback(window, key_callback);
+    assert(glewInit() == GLEW_OK);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    createGpuResources();
+
+    // --- COMPILAÇÃO DOS SHADERS DE ILUMINAÇÃO ---
+    GpuResource shaderProgram = compileProgram({ lightingVertexShader }, { sceneFragmentHeader, lightingFragmentCommon, lightingFragmentShader });
+    bindSceneSamplers(shaderProgram);
+    createLightClusters();
+    createOitPass();
+    createHud();
+    startTextureStreaming(2);
+    startOcclusionCuller();
+    createDynamicResolution();
+    createLatencyTracker();
+    
+    // --- CRIAÇÃO DAS GEOMETRIAS ---
+    SceneMeshes meshes = createSceneMeshes();
+    createGpuDriven(meshes);
+    createParticles();
+    createGrass();
+    resetGLStateCache(); // A inicialização mexeu no GL direto: o cache começa sem saber de nada
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    updateCamera();
+
+    int exitCode = 0;
+    if (g_benchOptions.enabled) {
+        exitCode = runBenchmark(window, shaderProgram, meshes);
+    } else {
+        printKickMessage();
+        startSimulationThread();
+        float lastFrameTime = 0.0f;
+
+        // --- LOOP PRINCIPAL DE RENDERIZAÇÃO ---
+        while (!glfwWindowShouldClose(window)) {
+            beginFrameLatency();
+            float currentFrameTime = glfwGetTime();
+            float deltaTime = currentFrameTime - lastFrameTime;
+            lastFrameTime = currentFrameTime;
+
+            // --- LÓGICA DE ATUALIZAÇÃO ---
+            glfwPollEvents();
+            const DrawList* prebuilt = nullptr;
+            if (g_pipeline.running) {
+                // A simulação deste frame roda na outra thread enquanto desenhamos o último pacote dela
+                const FramePacket& packet = acquireFramePacket(deltaTime);
+                applySnapshot(packet.snapshot);
+                prebuilt = &packet.list;
+            } else {
+                updateGame(deltaTime);
+                noteInput(g_kickInputTime);
+            }
+            if (g_gameState == STATE_GAMEOVER) glfwSetWindowShouldClose(window, true);
+
+            // --- LÓGICA DE DESENHO (RENDER) ---
+            if (g_lowLatency) glfwPollEvents(); // Câmera lida depois da simulação, o mais perto possível do desenho
+            processInput(window);
+            g_frameStats = FrameStats();
+            if (g_pipeline.running) g_frameStats.simMs = g_pipeline.simMs;
+            renderScene(shaderProgram, meshes, prebuilt);
+
+            double submitted = glfwGetTime();
+            glfwSwapBuffers(window);
+            endFrameLatency(submitted);
+            endFrameGpuResources();
+            frameArena().reset();
+        }
+    }
+    // --- LIMPEZA ---
+    stopSimulationThread();
+    destroyLatencyTracker();
+    destroyGpuDriven();
+    destroyParticles();
+    destroyGrass();
+    destroySceneMeshes(meshes);
+    shaderProgram.reset();
+    destroyOitPass();
+    destroyLightClusters();
+    destroyHud();
+    stopTextureStreaming();
+    stopOcclusionCuller();
+    destroyDynamicResolution();
+    destroyGpuResources();
+    glfwTerminate();
+    g_threadPool.stop();
+    stopEventLog();
+    stopAudio();
+    if (g_printArenaStats) printArenaStats();
+    if (g_glState.validate) std::cout << "Validacao do cache GL: " << g_glState.mismatches << " divergencias" << std::endl;
+    printPipelineStats();
+    printAudioStats();
+    printLatencyStats();
+    return exitCode;
+}